@@ -0,0 +1,564 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   wilton_usb_bench.cpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:34 AM
+ */
+
+// Measures read, write and control operations on the simulated device through
+// 'connection', through the C API and through the wiltoncall layer;
+// results are printed as JSON to stdout (or to the '--output' file),
+// human-readable table is printed to stderr.
+//
+// Heap allocations are counted with the replaced 'operator new' and
+// reported per operation, for the 'connection' layer steady-state reads,
+// writes and control transfers are expected to show zero.
+//
+// wilton_usb_bench [--sizes=64,4096,65536] [--threads=1,4] [--duration-millis=1000]
+//         [--layers=connection,capi,wiltoncall] [--ops=read,write,control]
+//         [--latency-micros=0] [--bytes-per-second=0]
+//         [--wiltoncall-config=<json>] [--output=<path>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/wilton.h"
+#include "wilton/wiltoncall.h"
+#include "wilton/wilton_usb.h"
+
+#include "wilton/support/exception.hpp"
+
+#include "connection.hpp"
+#include "control_request.hpp"
+#include "usb_config.hpp"
+
+extern "C" char* wilton_module_init();
+
+namespace { // anonymous
+
+// heap allocations made by the current thread, counted
+// by the replaced 'operator new' below
+thread_local uint64_t allocs_count = 0;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    allocs_count += 1;
+    void* ptr = std::malloc(0 != size ? size : 1);
+    if (nullptr == ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) STATICLIB_NOEXCEPT {
+    allocs_count += 1;
+    return std::malloc(0 != size ? size : 1);
+}
+
+void operator delete(void* ptr) STATICLIB_NOEXCEPT {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) STATICLIB_NOEXCEPT {
+    std::free(ptr);
+}
+
+namespace { // anonymous
+
+// returns number of payload bytes moved by one operation
+using bench_op = std::function<size_t()>;
+
+struct bench_options {
+    std::vector<size_t> sizes = {64, 4096, 65536};
+    std::vector<size_t> threads = {1, 4};
+    uint32_t duration_millis = 1000;
+    std::vector<std::string> layers = {"connection", "capi", "wiltoncall"};
+    std::vector<std::string> ops = {"read", "write", "control"};
+    uint32_t latency_micros = 0;
+    uint32_t bytes_per_second = 0;
+    std::string wiltoncall_config;
+    std::string output;
+};
+
+struct bench_result {
+    uint64_t ops = 0;
+    uint64_t bytes = 0;
+    uint64_t elapsed_nanos = 0;
+    uint64_t allocs = 0;
+    std::vector<uint64_t> latencies;
+};
+
+// upper bound of the latency samples kept per thread
+const size_t max_samples = 1 << 24;
+const size_t warmup_ops = 16;
+
+const uint8_t control_request_type = 0xc0;
+const uint8_t control_request_code = 0x01;
+const std::string control_response_hex = "0102030405060708";
+
+std::vector<std::string> split(const std::string& str) {
+    auto res = std::vector<std::string>();
+    size_t start = 0;
+    for (;;) {
+        size_t pos = str.find(',', start);
+        res.emplace_back(str.substr(start, std::string::npos != pos ? pos - start : std::string::npos));
+        if (std::string::npos == pos) {
+            return res;
+        }
+        start = pos + 1;
+    }
+}
+
+std::vector<size_t> split_numbers(const std::string& str) {
+    auto res = std::vector<size_t>();
+    for (auto& st : split(str)) {
+        res.push_back(static_cast<size_t>(std::stoull(st)));
+    }
+    return res;
+}
+
+bench_options parse_options(int argc, char** argv) {
+    auto res = bench_options();
+    for (int i = 1; i < argc; i++) {
+        auto arg = std::string(argv[i]);
+        auto eq = arg.find('=');
+        auto name = arg.substr(0, eq);
+        auto val = std::string::npos != eq ? arg.substr(eq + 1) : std::string();
+        if ("--sizes" == name) {
+            res.sizes = split_numbers(val);
+        } else if ("--threads" == name) {
+            res.threads = split_numbers(val);
+        } else if ("--duration-millis" == name) {
+            res.duration_millis = static_cast<uint32_t>(std::stoul(val));
+        } else if ("--layers" == name) {
+            res.layers = split(val);
+        } else if ("--ops" == name) {
+            res.ops = split(val);
+        } else if ("--latency-micros" == name) {
+            res.latency_micros = static_cast<uint32_t>(std::stoul(val));
+        } else if ("--bytes-per-second" == name) {
+            res.bytes_per_second = static_cast<uint32_t>(std::stoul(val));
+        } else if ("--wiltoncall-config" == name) {
+            res.wiltoncall_config = val;
+        } else if ("--output" == name) {
+            res.output = val;
+        } else {
+            throw wilton::support::exception(TRACEMSG("Unknown option: [" + arg + "]"));
+        }
+    }
+    return res;
+}
+
+// 'source' device: writes are discarded and reads are filled at once,
+// so only the module overhead and the configured limits are measured
+std::string device_config(const bench_options& opts) {
+    size_t max_size = *std::max_element(opts.sizes.begin(), opts.sizes.end());
+    auto responses = std::vector<sl::json::value>();
+    responses.emplace_back(sl::json::value({
+        { "requestType", control_request_type },
+        { "request", control_request_code },
+        { "dataHex", control_response_hex }
+    }));
+    auto conf = sl::json::value({
+        { "vendorId", 1 },
+        { "productId", 1 },
+        { "outEndpoint", 0x01 },
+        { "inEndpoint", 0x81 },
+        { "timeoutMillis", 1000 },
+        { "bufferSize", static_cast<uint32_t>(max_size) },
+        { "simulator", {
+                { "mode", "source" },
+                { "latencyMicros", opts.latency_micros },
+                { "bytesPerSecond", opts.bytes_per_second },
+                { "controlResponses", std::move(responses) }
+            }
+        }
+    });
+    return conf.dumps();
+}
+
+sl::json::value control_options() {
+    return {
+        { "requestType", control_request_type },
+        { "request", control_request_code }
+    };
+}
+
+void check_err(char* err) {
+    if (nullptr != err) {
+        auto msg = std::string(err);
+        wilton_free(err);
+        throw wilton::support::exception(TRACEMSG(msg));
+    }
+}
+
+bench_result run_case(const bench_op& op, size_t threads_count, uint32_t duration_millis) {
+    auto results = std::vector<bench_result>(threads_count);
+    auto threads = std::vector<std::thread>();
+    auto errors = std::vector<std::string>(threads_count);
+    auto start = std::chrono::steady_clock::now();
+    auto finish = start + std::chrono::milliseconds(duration_millis);
+    for (size_t i = 0; i < threads_count; i++) {
+        threads.emplace_back([&op, &results, &errors, finish, i] {
+            auto& res = results[i];
+            try {
+                // warmup, also used to size the samples buffer, so
+                // the timed loop does not allocate
+                auto warmup_start = std::chrono::steady_clock::now();
+                for (size_t j = 0; j < warmup_ops; j++) {
+                    op();
+                }
+                auto warmup_nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - warmup_start).count();
+                auto left_nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        finish - std::chrono::steady_clock::now()).count();
+                double op_nanos = std::max(1.0, static_cast<double>(warmup_nanos) / warmup_ops);
+                double expected = std::max(0.0, static_cast<double>(left_nanos)) / op_nanos;
+                res.latencies.reserve(std::min(max_samples, static_cast<size_t>(expected * 2) + 1024));
+                uint64_t allocs_before = allocs_count;
+                while (std::chrono::steady_clock::now() < finish) {
+                    auto op_start = std::chrono::steady_clock::now();
+                    size_t bytes = op();
+                    auto op_end = std::chrono::steady_clock::now();
+                    // samples over the reserved capacity are dropped
+                    if (res.latencies.size() < res.latencies.capacity()) {
+                        res.latencies.push_back(static_cast<uint64_t>(
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(op_end - op_start).count()));
+                    }
+                    res.bytes += bytes;
+                    res.ops += 1;
+                }
+                res.allocs = allocs_count - allocs_before;
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    for (auto& err : errors) {
+        if (!err.empty()) throw wilton::support::exception(TRACEMSG(err));
+    }
+    auto res = bench_result();
+    res.elapsed_nanos = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    for (auto& tr : results) {
+        res.ops += tr.ops;
+        res.bytes += tr.bytes;
+        res.allocs += tr.allocs;
+        res.latencies.insert(res.latencies.end(), tr.latencies.begin(), tr.latencies.end());
+    }
+    std::sort(res.latencies.begin(), res.latencies.end());
+    return res;
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double pct) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(pct * static_cast<double>(sorted.size() - 1));
+    return sorted[idx];
+}
+
+// layers
+
+class bench_layer {
+public:
+    virtual ~bench_layer() STATICLIB_NOEXCEPT { }
+
+    virtual bench_op make_op(const std::string& op, size_t size) = 0;
+};
+
+class connection_layer : public bench_layer {
+    wilton::usb::connection conn;
+    wilton::usb::control_request req;
+    std::string payload;
+
+public:
+    connection_layer(const std::string& conf, size_t max_size) :
+    conn(wilton::usb::usb_config(sl::json::load(conf))),
+    req(control_options()),
+    payload(max_size, 'x') { }
+
+    bench_op make_op(const std::string& op, size_t size) override {
+        if ("write" == op) {
+            return [this, size] {
+                return static_cast<size_t>(conn.write(sl::io::make_span(payload.data(), size)));
+            };
+        } else if ("read" == op) {
+            // buffer is shared between threads, contents are not checked
+            auto buf = std::make_shared<std::string>(size, '\0');
+            return [this, buf] {
+                return static_cast<size_t>(conn.read_into(sl::io::make_span(std::addressof(buf->front()), buf->size())));
+            };
+        }
+        return [this] {
+            return conn.execute_control(req, wilton::usb::control_overrides()).length();
+        };
+    }
+};
+
+class capi_layer : public bench_layer {
+    wilton_USB* usb = nullptr;
+    std::string payload;
+    std::string control_json;
+
+public:
+    capi_layer(const std::string& conf, size_t max_size) :
+    payload(max_size, 'x'),
+    control_json(control_options().dumps()) {
+        check_err(wilton_USB_open(std::addressof(usb), conf.c_str(), static_cast<int>(conf.length())));
+    }
+
+    ~capi_layer() STATICLIB_NOEXCEPT override {
+        char* err = wilton_USB_close(usb);
+        if (nullptr != err) {
+            wilton_free(err);
+        }
+    }
+
+    bench_op make_op(const std::string& op, size_t size) override {
+        if ("write" == op) {
+            return [this, size] {
+                int written = 0;
+                check_err(wilton_USB_write(usb, payload.data(), static_cast<int>(size), std::addressof(written)));
+                return static_cast<size_t>(written);
+            };
+        } else if ("read" == op) {
+            return [this, size] {
+                char* out = nullptr;
+                int out_len = 0;
+                check_err(wilton_USB_read(usb, static_cast<int>(size), std::addressof(out), std::addressof(out_len)));
+                wilton_free(out);
+                return static_cast<size_t>(out_len);
+            };
+        }
+        return [this] {
+            char* out = nullptr;
+            int out_len = 0;
+            check_err(wilton_USB_control(usb, control_json.c_str(), static_cast<int>(control_json.length()),
+                    std::addressof(out), std::addressof(out_len)));
+            wilton_free(out);
+            return static_cast<size_t>(out_len);
+        };
+    }
+};
+
+// input JSON is prepared once per case, hex encoding of the written
+// payload on the JS side is not included
+class wiltoncall_layer : public bench_layer {
+    int64_t handle = -1;
+
+public:
+    wiltoncall_layer(const std::string& conf) {
+        auto out = call("usb_open", conf);
+        handle = sl::json::load(out).getattr("usbHandle").as_int64_or_throw("usbHandle");
+    }
+
+    ~wiltoncall_layer() STATICLIB_NOEXCEPT override {
+        try {
+            call("usb_close", handle_json());
+        } catch (...) {
+            // ignore
+        }
+    }
+
+    bench_op make_op(const std::string& op, size_t size) override {
+        if ("write" == op) {
+            auto input = std::make_shared<std::string>(sl::json::value({
+                { "usbHandle", handle },
+                { "dataHex", sl::io::string_to_hex(std::string(size, 'x')) }
+            }).dumps());
+            return [input] {
+                auto out = call("usb_write", *input);
+                return static_cast<size_t>(sl::json::load(out).getattr("bytesWritten").as_int64_or_throw("bytesWritten"));
+            };
+        } else if ("read" == op) {
+            auto input = std::make_shared<std::string>(sl::json::value({
+                { "usbHandle", handle },
+                { "length", static_cast<uint64_t>(size) }
+            }).dumps());
+            return [input] {
+                // hex output
+                return call("usb_read", *input).length() / 2;
+            };
+        }
+        auto input = std::make_shared<std::string>(sl::json::value({
+            { "usbHandle", handle },
+            { "options", control_options() }
+        }).dumps());
+        return [input] {
+            return call("usb_control", *input).length() / 2;
+        };
+    }
+
+private:
+    std::string handle_json() {
+        return sl::json::value({
+            { "usbHandle", handle }
+        }).dumps();
+    }
+
+    static std::string call(const std::string& name, const std::string& input) {
+        char* out = nullptr;
+        int out_len = 0;
+        check_err(wiltoncall(name.c_str(), static_cast<int>(name.length()),
+                input.c_str(), static_cast<int>(input.length()),
+                std::addressof(out), std::addressof(out_len)));
+        if (nullptr == out) {
+            return std::string();
+        }
+        auto res = std::string(out, static_cast<size_t>(out_len));
+        wilton_free(out);
+        return res;
+    }
+};
+
+std::unique_ptr<bench_layer> make_layer(const std::string& name, const bench_options& opts,
+        const std::string& conf) {
+    size_t max_size = *std::max_element(opts.sizes.begin(), opts.sizes.end());
+    if ("connection" == name) {
+        return std::unique_ptr<bench_layer>(new connection_layer(conf, max_size));
+    } else if ("capi" == name) {
+        return std::unique_ptr<bench_layer>(new capi_layer(conf, max_size));
+    } else if ("wiltoncall" == name) {
+        return std::unique_ptr<bench_layer>(new wiltoncall_layer(conf));
+    }
+    throw wilton::support::exception(TRACEMSG("Invalid layer: [" + name + "]," +
+            " supported values: ['connection', 'capi', 'wiltoncall']"));
+}
+
+void init_wiltoncall(const bench_options& opts) {
+    if (!opts.wiltoncall_config.empty()) {
+        check_err(wiltoncall_init(opts.wiltoncall_config.c_str(),
+                static_cast<int>(opts.wiltoncall_config.length())));
+    }
+    check_err(wilton_module_init());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        auto opts = parse_options(argc, argv);
+        if (opts.sizes.empty() || opts.threads.empty()) throw wilton::support::exception(TRACEMSG(
+                "Options '--sizes' and '--threads' must not be empty"));
+        auto conf = device_config(opts);
+        bool wiltoncall_ready = false;
+        auto results = std::vector<sl::json::value>();
+        auto skipped = std::vector<sl::json::value>();
+        std::fprintf(stderr, "%-10s %-7s %8s %7s %12s %10s %10s %10s %10s %10s\n",
+                "layer", "op", "size", "threads", "ops/s", "MB/s", "p50 us", "p99 us", "p999 us", "allocs/op");
+        for (auto& layer_name : opts.layers) {
+            if ("wiltoncall" == layer_name && !wiltoncall_ready) {
+                try {
+                    init_wiltoncall(opts);
+                    wiltoncall_ready = true;
+                } catch (const std::exception& e) {
+                    skipped.emplace_back(sl::json::value({
+                        { "layer", layer_name },
+                        { "error", std::string(e.what()) }
+                    }));
+                    continue;
+                }
+            }
+            auto layer = make_layer(layer_name, opts, conf);
+            for (auto& op_name : opts.ops) {
+                if (!("read" == op_name || "write" == op_name || "control" == op_name)) {
+                    throw wilton::support::exception(TRACEMSG("Invalid op: [" + op_name + "]," +
+                            " supported values: ['read', 'write', 'control']"));
+                }
+                // control payload does not depend on the size
+                auto sizes = "control" == op_name ? std::vector<size_t>{0} : opts.sizes;
+                for (size_t size : sizes) {
+                    for (size_t threads : opts.threads) {
+                        auto op = layer->make_op(op_name, size);
+                        auto res = run_case(op, threads, opts.duration_millis);
+                        double secs = static_cast<double>(res.elapsed_nanos) / 1e9;
+                        double ops_per_sec = static_cast<double>(res.ops) / secs;
+                        double mb_per_sec = static_cast<double>(res.bytes) / secs / 1e6;
+                        uint64_t p50 = percentile(res.latencies, 0.5);
+                        uint64_t p99 = percentile(res.latencies, 0.99);
+                        uint64_t p999 = percentile(res.latencies, 0.999);
+                        double allocs_per_op = res.ops > 0 ?
+                                static_cast<double>(res.allocs) / static_cast<double>(res.ops) : 0;
+                        std::fprintf(stderr, "%-10s %-7s %8llu %7llu %12.0f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                                layer_name.c_str(), op_name.c_str(),
+                                static_cast<unsigned long long>(size), static_cast<unsigned long long>(threads),
+                                ops_per_sec, mb_per_sec, p50 / 1e3, p99 / 1e3, p999 / 1e3, allocs_per_op);
+                        results.emplace_back(sl::json::value({
+                            { "layer", layer_name },
+                            { "op", op_name },
+                            { "payloadSize", static_cast<uint64_t>(size) },
+                            { "threads", static_cast<uint64_t>(threads) },
+                            { "ops", res.ops },
+                            { "opsPerSec", ops_per_sec },
+                            { "mbPerSec", mb_per_sec },
+                            { "p50Nanos", p50 },
+                            { "p99Nanos", p99 },
+                            { "p999Nanos", p999 },
+                            { "latencySamples", static_cast<uint64_t>(res.latencies.size()) },
+                            { "allocsPerOp", allocs_per_op }
+                        }));
+                    }
+                }
+            }
+        }
+        auto json = sl::json::value({
+            { "durationMillis", opts.duration_millis },
+            { "latencyMicros", opts.latency_micros },
+            { "bytesPerSecond", opts.bytes_per_second },
+            { "results", std::move(results) },
+            { "skipped", std::move(skipped) }
+        });
+        auto str = json.dumps();
+        if (opts.output.empty()) {
+            std::cout << str << std::endl;
+        } else {
+            auto file = std::unique_ptr<std::FILE, int(*)(std::FILE*)>(std::fopen(opts.output.c_str(), "w"), std::fclose);
+            if (nullptr == file.get()) throw wilton::support::exception(TRACEMSG(
+                    "Error opening output file, path: [" + opts.output + "]"));
+            std::fwrite(str.data(), 1, str.length(), file.get());
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -38,12 +38,53 @@ char* wilton_USB_open(
         const char* conf,
         int conf_len);
 
+/**
+ * Lists attached devices matching VID/PID and optional selectors from
+ * the specified config, output is a JSON array of objects with
+ * 'busNumber', 'portPath' and 'serialNumber' fields
+ */
+char* wilton_USB_list(
+        const char* conf,
+        int conf_len,
+        char** list_out,
+        int* list_len_out);
+
 char* wilton_USB_read(
         wilton_USB* usb,
         int len,
         char** data_out,
         int* data_len_out);
 
+/**
+ * Reads from the IN endpoint of the named set from 'endpointSets' config,
+ * named sets can be used concurrently with the main endpoints
+ */
+char* wilton_USB_read_endpoint(
+        wilton_USB* usb,
+        const char* endpoint_name,
+        int endpoint_name_len,
+        int len,
+        char** data_out,
+        int* data_len_out);
+
+char* wilton_USB_write_endpoint(
+        wilton_USB* usb,
+        const char* endpoint_name,
+        int endpoint_name_len,
+        const char* data,
+        int data_len,
+        int* len_written_out);
+
+/**
+ * Returns one frame, as described by 'framing' JSON, as soon as it is
+ * received; empty data is returned on timeout
+ */
+char* wilton_USB_read_frame(
+        wilton_USB* usb,
+        const char* framing,
+        int framing_len,
+        char** data_out,
+        int* data_len_out);
 
 char* wilton_USB_write(
         wilton_USB* usb,
@@ -51,6 +92,37 @@ char* wilton_USB_write(
         int data_len,
         int* len_written_out);
 
+/**
+ * Writes specified segments as a single logical transfer
+ * without joining them into one buffer first
+ */
+char* wilton_USB_writev(
+        wilton_USB* usb,
+        const char** segments,
+        const int* segments_lens,
+        int segments_count,
+        int* len_written_out);
+
+/**
+ * Writes each request and reads its response under a single deadline,
+ * up to 'window' (from 'options' JSON) requests are written ahead;
+ * 'data_out' receives responses joined in order, caller-provided
+ * 'responses_lens_out' receives the length of each response, or '-1'
+ * if the transaction was not completed before the deadline; late responses
+ * to the already written requests are read and discarded for up to one
+ * more timeout interval before returning
+ */
+char* wilton_USB_transact(
+        wilton_USB* usb,
+        const char* options,
+        int options_len,
+        const char** requests,
+        const int* requests_lens,
+        int requests_count,
+        char** data_out,
+        int* data_len_out,
+        int* responses_lens_out);
+
 char* wilton_USB_control(
         wilton_USB* usb,
         const char* data,
@@ -58,9 +130,141 @@ char* wilton_USB_control(
         char** data_out,
         int* data_len_out);
 
+/**
+ * Parses and validates control options once, request fields and data size
+ * are checked against the connection 'bufferSize', returned id is used
+ * with 'wilton_USB_control_exec' and is valid until released
+ * or until the connection is closed
+ */
+char* wilton_USB_control_prepare(
+        wilton_USB* usb,
+        const char* options,
+        int options_len,
+        long long* id_out);
+
+/**
+ * Runs prepared control request, negative 'value' or 'index'
+ * and NULL 'data' keep the prepared values
+ */
+char* wilton_USB_control_exec(
+        wilton_USB* usb,
+        long long id,
+        int value,
+        int index,
+        const char* data,
+        int data_len,
+        char** data_out,
+        int* data_len_out);
+
+char* wilton_USB_control_release(
+        wilton_USB* usb,
+        long long id);
+
+/**
+ * Runs declarative script (JSON with 'steps' array) on the connection
+ * within a single call, result is a JSON object with captured variables
+ */
+char* wilton_USB_run_script(
+        wilton_USB* usb,
+        const char* script,
+        int script_len,
+        char** result_out,
+        int* result_len_out);
+
+/**
+ * Sends the file from 'path' option to the OUT endpoint with several
+ * transfers in flight, without loading it into memory; progress of the
+ * running write can be obtained from other thread with
+ * 'wilton_USB_write_file_stats'
+ */
+char* wilton_USB_write_file(
+        wilton_USB* usb,
+        const char* options,
+        int options_len,
+        char** result_out,
+        int* result_len_out);
+
+char* wilton_USB_write_file_stats(
+        wilton_USB* usb,
+        char** stats_out,
+        int* stats_len_out);
+
+/**
+ * Per-connection counters and latency histograms of read, write and
+ * control operations as JSON, non-zero 'reset' clears the counters
+ * after the snapshot is taken; frame reads and transaction responses
+ * are counted as reads, capture transfers are not counted
+ */
+char* wilton_USB_stats(
+        wilton_USB* usb,
+        int reset,
+        char** stats_out,
+        int* stats_len_out);
+
+/**
+ * Starts writing the IN endpoint stream to memory-mapped segment files
+ * on the background thread, captured endpoint cannot be read until
+ * 'wilton_USB_capture_stop' is called
+ */
+char* wilton_USB_capture_start(
+        wilton_USB* usb,
+        const char* options,
+        int options_len);
+
+char* wilton_USB_capture_stop(
+        wilton_USB* usb,
+        char** result_out,
+        int* result_len_out);
+
 char* wilton_USB_close(
         wilton_USB* usb);
 
+/**
+ * Submits the read and returns immediately, result
+ * must be obtained with 'wilton_USB_collect'; tickets, that
+ * are not collected, are released by 'wilton_USB_close'
+ */
+char* wilton_USB_read_async(
+        wilton_USB* usb,
+        int len,
+        long long* ticket_out);
+
+/**
+ * Submits the write and returns immediately, data is copied
+ * and can be released right after this call
+ */
+char* wilton_USB_write_async(
+        wilton_USB* usb,
+        const char* data,
+        int data_len,
+        long long* ticket_out);
+
+char* wilton_USB_poll(
+        long long ticket,
+        int* ready_out);
+
+/**
+ * Waits for any of the specified transfers to complete, 'ready_index_out'
+ * receives the index of a completed ticket or '-1' on timeout
+ */
+char* wilton_USB_wait(
+        const long long* tickets,
+        int tickets_count,
+        int timeout_millis,
+        int* ready_index_out);
+
+/**
+ * Blocks until the transfer is complete and releases the ticket;
+ * for reads 'data_out' receives the data and 'len_written_out' is set to '-1',
+ * for writes 'data_out' is set to NULL and 'len_written_out' receives
+ * the number of bytes written
+ */
+char* wilton_USB_collect(
+        long long ticket,
+        char** data_out,
+        int* data_len_out,
+        int* len_written_out);
+
 #ifdef __cplusplus
 }
 #endif
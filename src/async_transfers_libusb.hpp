@@ -0,0 +1,155 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   async_transfers_libusb.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:00 AM
+ */
+
+#ifndef WILTON_USB_ASYNC_TRANSFERS_LIBUSB_HPP
+#define WILTON_USB_ASYNC_TRANSFERS_LIBUSB_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "libusb-1.0/libusb.h"
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "transfer_future.hpp"
+#include "transfer_type.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Submits one-off transfers, that are completed by the context
+ * event thread, and tracks them, so all the transfers still in flight
+ * are cancelled and reaped before the device handle is closed
+ */
+class async_transfers_libusb {
+    struct transfer_ctx {
+        async_transfers_libusb* owner;
+        std::shared_ptr<transfer_future> future;
+        std::string buffer;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_set<libusb_transfer*> in_flight;
+    bool stopping = false;
+
+public:
+    async_transfers_libusb() { }
+
+    async_transfers_libusb(const async_transfers_libusb&) = delete;
+
+    async_transfers_libusb& operator=(const async_transfers_libusb&) = delete;
+
+    ~async_transfers_libusb() STATICLIB_NOEXCEPT {
+        std::unique_lock<std::mutex> lock{mutex};
+        stopping = true;
+        for (libusb_transfer* tr : in_flight) {
+            libusb_cancel_transfer(tr);
+        }
+        cv.wait(lock, [this] {
+            return in_flight.empty();
+        });
+    }
+
+    /**
+     * For IN transfers 'buffer' must be sized to the requested length,
+     * for OUT transfers it contains the data to write
+     */
+    std::shared_ptr<transfer_future> submit(libusb_device_handle* handle, unsigned char endpoint,
+            transfer_type ttype, transfer_future::kind op, std::string&& buffer,
+            unsigned int timeout_millis) {
+        auto tr = libusb_alloc_transfer(0);
+        if (nullptr == tr) throw support::exception(TRACEMSG("USB 'libusb_alloc_transfer' error"));
+        auto ctx = new transfer_ctx();
+        ctx->owner = this;
+        ctx->future = std::make_shared<transfer_future>(op);
+        ctx->buffer = std::move(buffer);
+        auto res = ctx->future;
+        auto buf = reinterpret_cast<unsigned char*>(std::addressof(ctx->buffer.front()));
+        auto len = static_cast<int>(ctx->buffer.length());
+        if (transfer_type::interrupt == ttype) {
+            libusb_fill_interrupt_transfer(tr, handle, endpoint, buf, len,
+                    async_transfers_libusb::on_complete, static_cast<void*>(ctx), timeout_millis);
+        } else {
+            libusb_fill_bulk_transfer(tr, handle, endpoint, buf, len,
+                    async_transfers_libusb::on_complete, static_cast<void*>(ctx), timeout_millis);
+        }
+        std::lock_guard<std::mutex> guard{mutex};
+        if (stopping) {
+            delete ctx;
+            libusb_free_transfer(tr);
+            throw support::exception(TRACEMSG("USB connection is closing"));
+        }
+        auto err = libusb_submit_transfer(tr);
+        if (LIBUSB_SUCCESS != err) {
+            delete ctx;
+            libusb_free_transfer(tr);
+            throw support::exception(TRACEMSG(
+                    "USB 'libusb_submit_transfer' error, code: [" + sl::support::to_string(err) + "]"));
+        }
+        in_flight.insert(tr);
+        return res;
+    }
+
+private:
+    static void LIBUSB_CALL on_complete(libusb_transfer* tr) {
+        auto ctx = static_cast<transfer_ctx*>(tr->user_data);
+        auto owner = ctx->owner;
+        auto& future = *ctx->future;
+        auto status = tr->status;
+        auto actual = static_cast<size_t>(tr->actual_length);
+        bool is_read = transfer_future::kind::read == future.get_kind();
+        if (LIBUSB_TRANSFER_COMPLETED == status || (is_read && LIBUSB_TRANSFER_TIMED_OUT == status)) {
+            // read timeout is not an error, partial data is returned the same way as with 'read'
+            if (is_read) {
+                ctx->buffer.resize(actual);
+                future.complete_read(std::move(ctx->buffer));
+            } else {
+                future.complete_write(static_cast<uint32_t>(actual));
+            }
+        } else if (LIBUSB_TRANSFER_CANCELLED == status) {
+            future.fail("USB transfer cancelled");
+        } else {
+            future.fail("USB async transfer error, status: [" + sl::support::to_string(static_cast<int>(status)) + "]," +
+                    " bytes transferred: [" + sl::support::to_string(actual) + "]");
+        }
+        delete ctx;
+        std::lock_guard<std::mutex> guard{owner->mutex};
+        owner->in_flight.erase(tr);
+        libusb_free_transfer(tr);
+        owner->cv.notify_all();
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_ASYNC_TRANSFERS_LIBUSB_HPP */
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   base64.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 8:57 AM
+ */
+
+#ifndef WILTON_USB_BASE64_HPP
+#define WILTON_USB_BASE64_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+namespace base64 {
+
+inline std::string encode(const char* data, size_t len) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    auto src = reinterpret_cast<const unsigned char*>(data);
+    auto res = std::string();
+    res.reserve(((len + 2) / 3) * 4);
+    size_t i = 0;
+    for (; i + 2 < len; i += 3) {
+        uint32_t triple = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        res.push_back(alphabet[(triple >> 18) & 0x3f]);
+        res.push_back(alphabet[(triple >> 12) & 0x3f]);
+        res.push_back(alphabet[(triple >> 6) & 0x3f]);
+        res.push_back(alphabet[triple & 0x3f]);
+    }
+    if (i < len) {
+        uint32_t triple = src[i] << 16;
+        if (i + 1 < len) {
+            triple |= src[i + 1] << 8;
+        }
+        res.push_back(alphabet[(triple >> 18) & 0x3f]);
+        res.push_back(alphabet[(triple >> 12) & 0x3f]);
+        res.push_back(i + 1 < len ? alphabet[(triple >> 6) & 0x3f] : '=');
+        res.push_back('=');
+    }
+    return res;
+}
+
+inline std::string decode(const std::string& str) {
+    auto value = [&str](char ch) -> uint32_t {
+        if (ch >= 'A' && ch <= 'Z') return static_cast<uint32_t>(ch - 'A');
+        if (ch >= 'a' && ch <= 'z') return static_cast<uint32_t>(ch - 'a' + 26);
+        if (ch >= '0' && ch <= '9') return static_cast<uint32_t>(ch - '0' + 52);
+        if ('+' == ch) return 62;
+        if ('/' == ch) return 63;
+        throw support::exception(TRACEMSG("Invalid Base64 character: [" + std::string(1, ch) + "]," +
+                " input length: [" + sl::support::to_string(str.length()) + "]"));
+    };
+    size_t len = str.length();
+    while (len > 0 && '=' == str[len - 1]) {
+        len -= 1;
+    }
+    // padding is optional, but when present it must complete the last quadruple
+    size_t padding = str.length() - len;
+    bool padding_valid = 0 == padding || (padding <= 2 && 0 == str.length() % 4 && 4 - len % 4 == padding);
+    if (1 == len % 4 || !padding_valid) throw support::exception(TRACEMSG(
+            "Invalid Base64 input length: [" + sl::support::to_string(str.length()) + "]," +
+            " padding: [" + sl::support::to_string(padding) + "]"));
+    auto res = std::string();
+    res.reserve((len * 3) / 4);
+    uint32_t acc = 0;
+    int bits = 0;
+    for (size_t i = 0; i < len; i++) {
+        acc = (acc << 6) | value(str[i]);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            res.push_back(static_cast<char>((acc >> bits) & 0xff));
+        }
+    }
+    return res;
+}
+
+} // namespace
+}
+}
+
+#endif /* WILTON_USB_BASE64_HPP */
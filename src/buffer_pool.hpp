@@ -0,0 +1,168 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   buffer_pool.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:16 AM
+ */
+
+#ifndef WILTON_USB_BUFFER_POOL_HPP
+#define WILTON_USB_BUFFER_POOL_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+class buffer_pool;
+
+/**
+ * Transfer buffer leased from the pool, is returned
+ * to the pool on destruction
+ */
+class pooled_buffer {
+    buffer_pool* pool;
+    std::unique_ptr<char[]> buf;
+    size_t cls;
+    size_t len;
+
+public:
+    pooled_buffer(buffer_pool* pool, std::unique_ptr<char[]> buf, size_t cls, size_t len) :
+    pool(pool),
+    buf(std::move(buf)),
+    cls(cls),
+    len(len) { }
+
+    pooled_buffer(const pooled_buffer&) = delete;
+
+    pooled_buffer& operator=(const pooled_buffer&) = delete;
+
+    pooled_buffer(pooled_buffer&& other) :
+    pool(other.pool),
+    buf(std::move(other.buf)),
+    cls(other.cls),
+    len(other.len) {
+        other.pool = nullptr;
+    }
+
+    pooled_buffer& operator=(pooled_buffer&&) = delete;
+
+    inline ~pooled_buffer() STATICLIB_NOEXCEPT;
+
+    char* data() {
+        return buf.get();
+    }
+
+    size_t size() const {
+        return len;
+    }
+};
+
+/**
+ * Per-connection set of reusable transfer buffers, buffers are
+ * grouped in power-of-two size classes; up to 'pool_size' free
+ * buffers are kept for every class, so after the first operations
+ * steady-state reads, writes and control transfers do not allocate
+ */
+class buffer_pool {
+    friend class pooled_buffer;
+
+    // 64 bytes
+    static const size_t min_class = 6;
+    // 1 GiB
+    static const size_t max_class = 30;
+
+    std::mutex mutex;
+    std::vector<std::vector<std::unique_ptr<char[]>>> free_lists;
+    size_t pool_size;
+
+public:
+    explicit buffer_pool(size_t pool_size) :
+    free_lists(max_class - min_class + 1),
+    pool_size(pool_size) { }
+
+    buffer_pool(const buffer_pool&) = delete;
+
+    buffer_pool& operator=(const buffer_pool&) = delete;
+
+    static size_t max_lease_size() {
+        return class_size(max_class - min_class);
+    }
+
+    pooled_buffer lease(size_t len) {
+        if (len > max_lease_size()) throw support::exception(TRACEMSG(
+                "Invalid buffer size requested: [" + sl::support::to_string(len) + "]," +
+                " max size: [" + sl::support::to_string(max_lease_size()) + "]"));
+        size_t cls = class_of(len);
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            auto& li = free_lists[cls];
+            if (!li.empty()) {
+                auto buf = std::move(li.back());
+                li.pop_back();
+                return pooled_buffer(this, std::move(buf), cls, len);
+            }
+        }
+        auto buf = std::unique_ptr<char[]>(new char[class_size(cls)]);
+        return pooled_buffer(this, std::move(buf), cls, len);
+    }
+
+private:
+    void give_back(std::unique_ptr<char[]> buf, size_t cls) STATICLIB_NOEXCEPT {
+        std::lock_guard<std::mutex> guard{mutex};
+        auto& li = free_lists[cls];
+        if (li.size() < pool_size) {
+            try {
+                li.emplace_back(std::move(buf));
+            } catch (...) {
+                // buffer is released
+            }
+        }
+    }
+
+    static size_t class_of(size_t len) {
+        size_t cls = 0;
+        while (class_size(cls) < len) {
+            cls += 1;
+        }
+        return cls;
+    }
+
+    static size_t class_size(size_t cls) {
+        return static_cast<size_t>(1) << (cls + min_class);
+    }
+};
+
+pooled_buffer::~pooled_buffer() STATICLIB_NOEXCEPT {
+    if (nullptr != pool && nullptr != buf.get()) {
+        pool->give_back(std::move(buf), cls);
+    }
+}
+
+} // namespace
+}
+
+#endif /* WILTON_USB_BUFFER_POOL_HPP */
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   byte_ring.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 8:55 AM
+ */
+
+#ifndef WILTON_USB_BYTE_RING_HPP
+#define WILTON_USB_BYTE_RING_HPP
+
+#include <cstring>
+#include <vector>
+
+#include "staticlib/config.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Fixed-capacity FIFO of bytes, allocated once on construction;
+ * not thread-safe, access must be guarded by the owner
+ */
+class byte_ring {
+    std::vector<char> buf;
+    size_t head = 0;
+    size_t len = 0;
+
+public:
+    explicit byte_ring(size_t capacity) :
+    buf(capacity, '\0') { }
+
+    byte_ring(const byte_ring&) = delete;
+
+    byte_ring& operator=(const byte_ring&) = delete;
+
+    size_t size() const {
+        return len;
+    }
+
+    size_t capacity() const {
+        return buf.size();
+    }
+
+    size_t available() const {
+        return buf.size() - len;
+    }
+
+    bool empty() const {
+        return 0 == len;
+    }
+
+    /**
+     * Appends up to 'count' bytes, returns number of bytes actually appended
+     */
+    size_t write(const char* data, size_t count) {
+        size_t to_write = count < available() ? count : available();
+        size_t tail = (head + len) % buf.size();
+        size_t first = to_write < buf.size() - tail ? to_write : buf.size() - tail;
+        std::memcpy(buf.data() + tail, data, first);
+        std::memcpy(buf.data(), data + first, to_write - first);
+        len += to_write;
+        return to_write;
+    }
+
+    /**
+     * Removes up to 'count' bytes from the front, returns number of bytes actually copied out
+     */
+    size_t read(char* dest, size_t count) {
+        size_t to_read = count < len ? count : len;
+        size_t first = to_read < buf.size() - head ? to_read : buf.size() - head;
+        std::memcpy(dest, buf.data() + head, first);
+        std::memcpy(dest + first, buf.data(), to_read - first);
+        head = (head + to_read) % buf.size();
+        len -= to_read;
+        if (0 == len) {
+            head = 0;
+        }
+        return to_read;
+    }
+
+    void clear() {
+        head = 0;
+        len = 0;
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_BYTE_RING_HPP */
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   capture_files_posix.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:27 AM
+ */
+
+#ifndef WILTON_USB_CAPTURE_FILES_POSIX_HPP
+#define WILTON_USB_CAPTURE_FILES_POSIX_HPP
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/utils.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "capture_options.hpp"
+#include "mapped_file_posix.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Segment file of the fixed capacity, the file is truncated
+ * to the written size on close
+ */
+class mapped_segment {
+    mapped_file file;
+    size_t written = 0;
+
+public:
+    mapped_segment(const std::string& path, size_t capacity) :
+    file(path, capacity) {
+        file.truncate_on_close(0);
+    }
+
+    mapped_segment(const mapped_segment&) = delete;
+
+    mapped_segment& operator=(const mapped_segment&) = delete;
+
+    const std::string& file_path() const {
+        return file.file_path();
+    }
+
+    char* tail() {
+        return file.writable_data() + written;
+    }
+
+    size_t available() const {
+        return file.size() - written;
+    }
+
+    size_t size() const {
+        return written;
+    }
+
+    void advance(size_t count) {
+        written += count;
+        file.truncate_on_close(written);
+    }
+};
+
+/**
+ * Segment rotation and timestamp index of the single capture,
+ * used only from the capture thread; index file contains one line
+ * '<segment> <offset> <epochMillis>' for the first chunk of each
+ * segment and then at most once per 'indexIntervalMillis'
+ */
+class capture_files {
+    std::string directory;
+    std::string prefix;
+    uint32_t segment_size;
+    uint32_t segment_duration_millis;
+    uint32_t max_segments;
+    uint32_t index_interval_millis;
+
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> index;
+    std::unique_ptr<mapped_segment> segment;
+    std::deque<std::string> kept;
+    uint64_t segment_number = 0;
+    uint64_t segment_started = 0;
+    uint64_t last_indexed = 0;
+    uint64_t total_bytes = 0;
+
+public:
+    capture_files(const capture_options& options) :
+    directory(options.directory),
+    prefix(options.prefix),
+    segment_size(options.segment_size),
+    segment_duration_millis(options.segment_duration_millis),
+    max_segments(options.max_segments),
+    index_interval_millis(options.index_interval_millis),
+    index(open_index(options.directory + "/" + options.prefix + ".idx")) {
+        open_segment();
+    }
+
+    capture_files(const capture_files&) = delete;
+
+    capture_files& operator=(const capture_files&) = delete;
+
+    /**
+     * Returns the memory for the next chunk of up to 'len' bytes,
+     * segment is rotated first, if it has less space left
+     * or if its 'segmentDurationMillis' is passed
+     */
+    sl::io::span<char> next_chunk(size_t len) {
+        bool expired = segment_duration_millis > 0 && segment->size() > 0 &&
+                sl::utils::current_time_millis_steady() - segment_started >= segment_duration_millis;
+        if (expired || segment->available() < len) {
+            rotate();
+        }
+        return sl::io::make_span(segment->tail(), len);
+    }
+
+    void commit(size_t count) {
+        if (0 == count) {
+            return;
+        }
+        uint64_t now = sl::utils::current_time_millis_steady();
+        if (0 == segment->size() || now - last_indexed >= index_interval_millis) {
+            std::fprintf(index.get(), "%llu %llu %llu\n",
+                    static_cast<unsigned long long>(segment_number),
+                    static_cast<unsigned long long>(segment->size()),
+                    static_cast<unsigned long long>(sl::utils::current_time_millis()));
+            std::fflush(index.get());
+            last_indexed = now;
+        }
+        segment->advance(count);
+        total_bytes += count;
+    }
+
+    uint64_t bytes_captured() const {
+        return total_bytes;
+    }
+
+    uint64_t segments_count() const {
+        return segment_number;
+    }
+
+    const std::string& current_segment() const {
+        return segment->file_path();
+    }
+
+private:
+    void rotate() {
+        segment.reset();
+        open_segment();
+    }
+
+    void open_segment() {
+        segment_number += 1;
+        std::array<char, 16> num;
+        std::snprintf(num.data(), num.size(), "%06llu", static_cast<unsigned long long>(segment_number));
+        auto path = directory + "/" + prefix + "-" + num.data() + ".bin";
+        segment = sl::support::make_unique<mapped_segment>(path, segment_size);
+        segment_started = sl::utils::current_time_millis_steady();
+        kept.push_back(path);
+        while (max_segments > 0 && kept.size() > max_segments) {
+            std::remove(kept.front().c_str());
+            kept.pop_front();
+        }
+    }
+
+    static std::unique_ptr<std::FILE, int(*)(std::FILE*)> open_index(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (nullptr == file) throw support::exception(TRACEMSG(
+                "Error opening capture index file, path: [" + path + "], error: [" + ::strerror(errno) + "]"));
+        return std::unique_ptr<std::FILE, int(*)(std::FILE*)>(file, std::fclose);
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_CAPTURE_FILES_POSIX_HPP */
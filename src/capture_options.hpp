@@ -0,0 +1,134 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   capture_options.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:27 AM
+ */
+
+#ifndef WILTON_USB_CAPTURE_OPTIONS_HPP
+#define WILTON_USB_CAPTURE_OPTIONS_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Describes where the captured IN stream is stored: segment files
+ * '<prefix>-<number>.bin' are rotated by size and, optionally, by time,
+ * '<prefix>.idx' receives timestamps of the stream positions
+ */
+class capture_options {
+public:
+    std::string directory;
+    std::string prefix = "capture";
+    // empty means the main IN endpoint
+    std::string endpoint;
+    uint32_t segment_size = 64 * 1024 * 1024;
+    // zero means no time-based rotation
+    uint32_t segment_duration_millis = 0;
+    // oldest segments are deleted, zero means keep all
+    uint32_t max_segments = 0;
+    uint32_t index_interval_millis = 1000;
+    // zero means connection 'bufferSize'
+    uint32_t chunk_size = 0;
+
+    capture_options(const capture_options&) = delete;
+
+    capture_options& operator=(const capture_options&) = delete;
+
+    capture_options(capture_options&& other) :
+    directory(std::move(other.directory)),
+    prefix(std::move(other.prefix)),
+    endpoint(std::move(other.endpoint)),
+    segment_size(other.segment_size),
+    segment_duration_millis(other.segment_duration_millis),
+    max_segments(other.max_segments),
+    index_interval_millis(other.index_interval_millis),
+    chunk_size(other.chunk_size) { }
+
+    capture_options& operator=(capture_options&& other) {
+        directory = std::move(other.directory);
+        prefix = std::move(other.prefix);
+        endpoint = std::move(other.endpoint);
+        segment_size = other.segment_size;
+        segment_duration_millis = other.segment_duration_millis;
+        max_segments = other.max_segments;
+        index_interval_millis = other.index_interval_millis;
+        chunk_size = other.chunk_size;
+        return *this;
+    }
+
+    capture_options() { }
+
+    capture_options(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("directory" == name) {
+                this->directory = fi.as_string_nonempty_or_throw(name);
+            } else if ("prefix" == name) {
+                this->prefix = fi.as_string_nonempty_or_throw(name);
+            } else if ("endpoint" == name) {
+                this->endpoint = fi.as_string_nonempty_or_throw(name);
+            } else if ("segmentSize" == name) {
+                this->segment_size = fi.as_uint32_positive_or_throw(name);
+            } else if ("segmentDurationMillis" == name) {
+                this->segment_duration_millis = fi.as_uint32_or_throw(name);
+            } else if ("maxSegments" == name) {
+                this->max_segments = fi.as_uint32_or_throw(name);
+            } else if ("indexIntervalMillis" == name) {
+                this->index_interval_millis = fi.as_uint32_or_throw(name);
+            } else if ("chunkSize" == name) {
+                this->chunk_size = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'capture' field: [" + name + "]"));
+            }
+        }
+        if (directory.empty()) throw support::exception(TRACEMSG(
+                "Required parameter 'directory' not specified"));
+        if (chunk_size > segment_size) throw support::exception(TRACEMSG(
+                "Invalid 'chunkSize' field: [" + sl::support::to_string(chunk_size) + "]," +
+                " must not exceed 'segmentSize': [" + sl::support::to_string(segment_size) + "]"));
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "directory", directory },
+            { "prefix", prefix },
+            { "endpoint", endpoint },
+            { "segmentSize", segment_size },
+            { "segmentDurationMillis", segment_duration_millis },
+            { "maxSegments", max_segments },
+            { "indexIntervalMillis", index_interval_millis },
+            { "chunkSize", chunk_size }
+        };
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_CAPTURE_OPTIONS_HPP */
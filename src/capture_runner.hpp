@@ -0,0 +1,157 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   capture_runner.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:49 AM
+ */
+
+#ifndef WILTON_USB_CAPTURE_RUNNER_HPP
+#define WILTON_USB_CAPTURE_RUNNER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "staticlib/config.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "capture_files_posix.hpp"
+#include "capture_options.hpp"
+
+namespace wilton {
+namespace usb {
+
+// capture reads return at least this often, to notice the stop request
+const uint32_t capture_poll_millis = 100;
+
+/**
+ * IN stream written to segment files from the background thread,
+ * 'error' is set by the thread before it exits
+ */
+struct capture_session {
+    capture_options options;
+    capture_files files;
+    std::atomic<bool> stopping;
+    std::string error;
+    std::thread thread;
+
+    capture_session(capture_options&& opts) :
+    options(std::move(opts)),
+    files(this->options),
+    stopping(false) { }
+
+    capture_session(const capture_session&) = delete;
+
+    capture_session& operator=(const capture_session&) = delete;
+};
+
+/**
+ * Capture of a single connection, shared by the backends; the captured
+ * IN endpoint is not available for reads until the capture is stopped.
+ * Backend must call 'close' before destroying the state used by the reader.
+ */
+class capture_runner {
+    std::mutex mutex;
+    std::unique_ptr<capture_session> session;
+
+public:
+    capture_runner() { }
+
+    capture_runner(const capture_runner&) = delete;
+
+    capture_runner& operator=(const capture_runner&) = delete;
+
+    ~capture_runner() STATICLIB_NOEXCEPT {
+        close();
+    }
+
+    /**
+     * Reader is called from the capture thread with the chunk of the mapped
+     * segment and the poll timeout, it returns the number of bytes read
+     * and must be safe to call concurrently with the connection operations
+     */
+    template<typename Reader>
+    void start(capture_options&& options, uint32_t default_chunk, uint32_t timeout_millis, Reader reader) {
+        uint32_t chunk = options.chunk_size > 0 ? options.chunk_size :
+                std::min(default_chunk, options.segment_size);
+        uint32_t poll = std::min(timeout_millis, capture_poll_millis);
+        std::lock_guard<std::mutex> guard{mutex};
+        if (nullptr != session.get()) throw support::exception(TRACEMSG(
+                "Capture is already running, file: [" + session->files.current_segment() + "]"));
+        // files are opened here, so path errors are reported to the caller
+        auto created = sl::support::make_unique<capture_session>(std::move(options));
+        auto sptr = created.get();
+        created->thread = std::thread([sptr, chunk, poll, reader] {
+            try {
+                while (!sptr->stopping.load(std::memory_order_acquire)) {
+                    auto dest = sptr->files.next_chunk(chunk);
+                    sptr->files.commit(reader(dest.data(), dest.size(), poll));
+                }
+            } catch (const std::exception& e) {
+                sptr->error = TRACEMSG(e.what() + "\nCapture stopped");
+            }
+        });
+        this->session = std::move(created);
+    }
+
+    sl::json::value stop() {
+        std::lock_guard<std::mutex> guard{mutex};
+        if (nullptr == session.get()) throw support::exception(TRACEMSG(
+                "Capture is not running"));
+        session->stopping.store(true, std::memory_order_release);
+        session->thread.join();
+        auto stopped = std::move(session);
+        return {
+            { "bytesCaptured", stopped->files.bytes_captured() },
+            { "segmentsCount", stopped->files.segments_count() },
+            { "lastSegment", stopped->files.current_segment() },
+            { "error", stopped->error }
+        };
+    }
+
+    // empty name means the main IN endpoint
+    void check_not_captured(const std::string& endpoint_name) {
+        std::lock_guard<std::mutex> guard{mutex};
+        if (nullptr != session.get() && session->options.endpoint == endpoint_name) {
+            throw support::exception(TRACEMSG(
+                    "IN endpoint is used by the running capture, file: [" + session->files.current_segment() + "]"));
+        }
+    }
+
+    void close() STATICLIB_NOEXCEPT {
+        std::lock_guard<std::mutex> guard{mutex};
+        if (nullptr != session.get()) {
+            session->stopping.store(true, std::memory_order_release);
+            session->thread.join();
+            session.reset();
+        }
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_CAPTURE_RUNNER_HPP */
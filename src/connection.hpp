@@ -24,12 +24,18 @@
 #ifndef WILTON_USB_CONNECTION_HPP
 #define WILTON_USB_CONNECTION_HPP
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "staticlib/config.hpp"
 #include "staticlib/io.hpp"
 #include "staticlib/pimpl.hpp"
 
+#include "control_request.hpp"
+#include "frame_spec.hpp"
+#include "transaction_options.hpp"
+#include "transfer_future.hpp"
 #include "usb_config.hpp"
 
 namespace wilton {
@@ -54,10 +60,91 @@ public:
 
     std::string read(uint32_t length);
 
+    /**
+     * Reads directly into the caller memory, returns number of bytes read
+     */
+    uint32_t read_into(sl::io::span<char> dest);
+
+    /**
+     * Returns one frame as soon as it is received, or empty string on timeout;
+     * bytes received after the frame are returned by subsequent reads
+     */
+    std::string read_frame(const sl::json::value& framing);
+
+    /**
+     * Reads the frame with already parsed spec, used when the same
+     * framing is read repeatedly
+     */
+    std::string read_frame(const frame_spec& spec);
+
+    /**
+     * Reads from the IN endpoint of the named endpoint set from 'endpointSets',
+     * named sets are used concurrently with the main endpoints and each other
+     */
+    std::string read_endpoint(const std::string& name, uint32_t length);
+
     uint32_t write(sl::io::span<const char> data);
 
+    uint32_t write_endpoint(const std::string& name, sl::io::span<const char> data);
+
+    uint32_t writev(const std::vector<sl::io::span<const char>>& segments);
+
+    /**
+     * Writes each request and reads its response under a single deadline,
+     * returns responses of the completed transactions in order
+     */
+    std::vector<std::string> transact(const std::vector<sl::io::span<const char>>& requests,
+            const transaction_options& options);
+
     std::string control(const sl::json::value& control_options);
 
+    /**
+     * Parses control request and checks it against the connection limits,
+     * so invalid prepared requests are rejected before the first call
+     */
+    control_request prepare_control(const sl::json::value& control_options);
+
+    /**
+     * Runs already parsed control request, used for prepared requests
+     * to skip JSON handling on every call
+     */
+    std::string execute_control(const control_request& req, const control_overrides& overrides);
+
+    std::shared_ptr<transfer_future> read_async(uint32_t length);
+
+    std::shared_ptr<transfer_future> write_async(sl::io::span<const char> data);
+
+    /**
+     * Sends the memory-mapped file to the OUT endpoint with several
+     * transfers in flight, progress is available from 'write_file_stats'
+     */
+    sl::json::value write_file(const sl::json::value& file_write_options);
+
+    sl::json::value write_file_stats();
+
+    /**
+     * Starts writing the IN stream to the segment files on the background
+     * thread, captured endpoint cannot be read until the capture is stopped
+     */
+    void capture_start(const sl::json::value& capture_options);
+
+    /**
+     * Stops the capture and returns its totals with the error, that stopped
+     * the capture thread early, if any
+     */
+    sl::json::value capture_stop();
+
+    /**
+     * Counters and latency histograms of read, write and control
+     * operations, with 'reset' counters are cleared after the snapshot
+     */
+    sl::json::value stats(bool reset);
+
+    /**
+     * Descriptions of all attached devices matching the config selectors
+     */
+    static std::vector<sl::json::value> list(const usb_config& conf);
+
     static void initialize();
 };
 
@@ -23,11 +23,17 @@
 
 #include "connection.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -42,236 +48,992 @@
 
 #include "wilton/support/exception.hpp"
 
+#include "async_transfers_libusb.hpp"
+#include "buffer_pool.hpp"
+#include "capture_options.hpp"
+#include "capture_runner.hpp"
+#include "control_request.hpp"
+#include "device_index_libusb.hpp"
+#include "file_write_options.hpp"
+#include "file_write_progress.hpp"
+#include "frame_reader.hpp"
+#include "handle_pool_libusb.hpp"
+#include "iso_stream_libusb.hpp"
+#include "mapped_file_posix.hpp"
+#include "out_pipeline_libusb.hpp"
+#include "read_ahead_libusb.hpp"
+#include "transact_loop.hpp"
+#include "transaction_options.hpp"
+#include "transfer_stats.hpp"
+
 namespace wilton {
 namespace usb {
 
 namespace { // anonymous
 
+// owns libusb context and the background thread that handles its events,
+// so asynchronous transfers are completed without any caller pumping the loop
+class context_holder {
+    libusb_context* ctx = nullptr;
+    std::atomic<bool> running;
+    handle_pool_libusb pool;
+    std::thread events_thread;
+    std::unique_ptr<device_index_libusb> index;
+
+public:
+    context_holder() :
+    running(true) {
+        auto err = libusb_init(std::addressof(ctx));
+        if (LIBUSB_SUCCESS != err) {
+            throw support::exception(TRACEMSG(
+                    "USB 'libusb_init' error, code: [" + sl::support::to_string(err) + "]"));
+        }
+        this->events_thread = std::thread([this] {
+            while (running.load()) {
+                struct timeval tv;
+                tv.tv_sec = 0;
+                tv.tv_usec = 100000;
+                libusb_handle_events_timeout_completed(ctx, std::addressof(tv), nullptr);
+                pool.evict_idle();
+            }
+        });
+        // hotplug notifications are delivered by the event thread
+        this->index = sl::support::make_unique<device_index_libusb>(ctx);
+    }
+
+    context_holder(const context_holder&) = delete;
+
+    context_holder& operator=(const context_holder&) = delete;
+
+    // event thread must be joined before 'libusb_exit'
+    ~context_holder() STATICLIB_NOEXCEPT {
+        pool.clear();
+        index.reset();
+        running.store(false);
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+        libusb_interrupt_event_handler(ctx);
+#endif // LIBUSB_API_VERSION
+        if (events_thread.joinable()) {
+            events_thread.join();
+        }
+        libusb_exit(ctx);
+    }
+
+    libusb_context* get() {
+        return ctx;
+    }
+
+    device_index_libusb& devices() {
+        return *index;
+    }
+
+    handle_pool_libusb& handles() {
+        return pool;
+    }
+};
+
 // initialized from wilton_module_init
-std::shared_ptr<libusb_context> shared_context() {
-    static std::shared_ptr<libusb_context> ctx = 
-            []() -> std::unique_ptr<libusb_context, std::function<void(libusb_context*)>> {
-                libusb_context* ctx = nullptr;
-                auto err = libusb_init(std::addressof(ctx));
-                if (LIBUSB_SUCCESS != err) {
-                    throw support::exception(TRACEMSG(
-                            "USB 'libusb_init' error, code: [" + sl::support::to_string(err) + "]"));
-                }
-                return std::unique_ptr<libusb_context, std::function<void(libusb_context*)>> (
-                        ctx, [](libusb_context* ctx) {
-                            libusb_exit(ctx);
-                        });
-            }();
-    return ctx;
+context_holder& shared_context() {
+    static std::shared_ptr<context_holder> holder = std::make_shared<context_holder>();
+    return *holder;
 }
 
+// handle and everything that is bound to it, replaced as a whole on reconnect
+struct opened_device {
+    std::unique_ptr<libusb_device_handle, std::function<void(libusb_device_handle*)>> handle;
+
+    // must be destroyed before the handle
+    std::unique_ptr<read_ahead_libusb> read_ahead;
+    std::unique_ptr<iso_in_stream_libusb> iso_in;
+    std::unique_ptr<iso_out_stream_libusb> iso_out;
+    async_transfers_libusb async_transfers;
+
+    opened_device(libusb_device_handle* ha, std::function<void(libusb_device_handle*)> closer) :
+    handle(ha, std::move(closer)) { }
+
+    opened_device(const opened_device&) = delete;
+
+    opened_device& operator=(const opened_device&) = delete;
+};
+
+// named endpoint pair, used independently from the main endpoints
+struct endpoint_stream {
+    uint32_t in_endpoint;
+    uint32_t out_endpoint;
+    transfer_type in_transfer_type;
+    transfer_type out_transfer_type;
+    std::mutex in_mutex;
+    std::mutex out_mutex;
+
+    endpoint_stream(const endpoint_set_config& es) :
+    in_endpoint(es.in_endpoint),
+    out_endpoint(es.out_endpoint),
+    in_transfer_type(es.in_transfer_type),
+    out_transfer_type(es.out_transfer_type) { }
+
+    endpoint_stream(const endpoint_stream&) = delete;
+
+    endpoint_stream& operator=(const endpoint_stream&) = delete;
+};
+
+// max 'wLength' of the control transfer
+const size_t control_max_length = 0xffff;
+
 } // namespace
 
 class connection::impl : public staticlib::pimpl::object::impl {
     usb_config conf;
 
-    std::unique_ptr<libusb_device_handle, std::function<void(libusb_device_handle*)>> handle;
+    // operations take a reference to the current device, so it is closed
+    // only after all the operations started before the reconnect are finished
+    std::mutex device_mutex;
+    std::shared_ptr<opened_device> device;
+    // serializes reconnect attempts, held while waiting for the device
+    std::mutex reconnect_mutex;
+
+    // IN, OUT and control transfers are independent,
+    // operations are only serialized per direction
+    std::mutex in_mutex;
+    std::mutex out_mutex;
+    std::mutex control_mutex;
+
+    // guarded by 'in_mutex'
+    frame_reader frames;
+
+    buffer_pool buffers;
+
+    // created on open and never changed, so lookups are not locked
+    std::map<std::string, std::unique_ptr<endpoint_stream>> streams;
+
+    capture_runner capture;
+
+    file_write_progress file_progress;
+
+    transfer_stats counters;
 
 public:
     impl(usb_config&& conf) :
     conf(std::move(conf)),
-    handle(find_and_open_by_vid_pid(this->conf.vendor_id, this->conf.product_id),
-            [this](libusb_device_handle* ha) {
-                libusb_release_interface(ha, 0);
-                libusb_close(ha);
-            }) { }
+    buffers(this->conf.pool_size) {
+        if (this->conf.simulated) throw support::exception(TRACEMSG(
+                "Parameter 'simulator' requires the module built with 'WILTON_USB_BACKEND=sim'"));
+        for (auto& en : this->conf.endpoint_sets) {
+            streams.emplace(en.first, sl::support::make_unique<endpoint_stream>(en.second));
+        }
+        auto leased = this->conf.pooled ? lease_pooled(this->conf) : pooled_handle();
+        if (nullptr != leased.handle) {
+            // pooled handle may have been claimed with other interfaces
+            claim_or_close(leased.handle, this->conf, leased.interfaces);
+            this->device = setup_device(leased.handle, std::addressof(leased.serial),
+                    claimed_interfaces(this->conf, std::move(leased.interfaces)));
+        } else {
+            this->device = setup_device(find_and_open(this->conf), nullptr,
+                    claimed_interfaces(this->conf, std::vector<int>()));
+        }
+    }
+
+    ~impl() STATICLIB_NOEXCEPT {
+        capture.close();
+    }
+
+    std::string read(connection& frontend, uint32_t length) {
+        auto res = std::string();
+        res.resize(length);
+        uint32_t read = read_into(frontend, sl::io::make_span(std::addressof(res.front()), res.length()));
+        res.resize(read);
+        return res;
+    }
+
+    uint32_t read_into(connection&, sl::io::span<char> dest) {
+        capture.check_not_captured(std::string());
+        std::lock_guard<std::mutex> guard{in_mutex};
+        stats_scope scope(counters.read);
+        size_t got = 0;
+        if (!frames.empty()) {
+            got = frames.take(dest.data(), dest.size());
+            if (got == dest.size()) {
+                return scope.done(dest.size(), static_cast<uint32_t>(got));
+            }
+        }
+        char* ptr = dest.data() + got;
+        uint32_t remaining = static_cast<uint32_t>(dest.size() - got);
+        got += with_device<size_t>([this, ptr, remaining](opened_device& dev) {
+            return this->read_device(dev, ptr, remaining, conf.timeout_millis);
+        });
+        return scope.done(dest.size(), static_cast<uint32_t>(got));
+    }
+
+    std::string read_frame(connection& frontend, const sl::json::value& framing) {
+        auto spec = frame_spec(framing);
+        return read_frame(frontend, spec);
+    }
+
+    std::string read_frame(connection&, const frame_spec& spec) {
+        capture.check_not_captured(std::string());
+        std::lock_guard<std::mutex> guard{in_mutex};
+        stats_scope scope(counters.read);
+        return scope.done_message(frames.read_frame(spec, conf.timeout_millis, conf.buffer_size,
+                [this](char* dest, size_t chunk, uint32_t timeout_millis) {
+            return this->with_device<size_t>([this, dest, chunk, timeout_millis](opened_device& dev) {
+                return this->read_some(dev, dest, chunk, timeout_millis, std::addressof(counters.read));
+            });
+        }));
+    }
+
+    std::string read_endpoint(connection&, const std::string& name, uint32_t length) {
+        auto& st = find_stream(name);
+        if (0 == st.in_endpoint) throw support::exception(TRACEMSG(
+                "IN endpoint not specified for endpoint set: [" + name + "]"));
+        capture.check_not_captured(name);
+        std::lock_guard<std::mutex> guard{st.in_mutex};
+        stats_scope scope(counters.read);
+        auto res = std::string();
+        res.resize(length);
+        char* ptr = std::addressof(res.front());
+        size_t got = with_device<size_t>([this, &st, ptr, length](opened_device& dev) {
+            return this->read_sync(dev, st.in_endpoint, st.in_transfer_type, ptr, length, conf.timeout_millis,
+                    std::addressof(counters.read));
+        });
+        res.resize(scope.done(length, got));
+        return res;
+    }
+
+    uint32_t write_endpoint(connection&, const std::string& name, sl::io::span<const char> data) {
+        auto& st = find_stream(name);
+        if (0 == st.out_endpoint) throw support::exception(TRACEMSG(
+                "OUT endpoint not specified for endpoint set: [" + name + "]"));
+        std::lock_guard<std::mutex> guard{st.out_mutex};
+        stats_scope scope(counters.write);
+        return scope.done(data.size(), with_device<uint32_t>([this, &st, &data](opened_device& dev) -> uint32_t {
+            uint64_t finish = sl::utils::current_time_millis_steady() + conf.timeout_millis;
+            size_t written = this->write_sync(dev, st.out_endpoint, st.out_transfer_type, data.data(), data.size(), finish);
+            return static_cast<uint32_t>(written);
+        }));
+    }
+
+    uint32_t write(connection&, sl::io::span<const char> data) {
+        std::lock_guard<std::mutex> guard{out_mutex};
+        stats_scope scope(counters.write);
+        return scope.done(data.size(), with_device<uint32_t>([this, &data](opened_device& dev) -> uint32_t {
+            uint64_t finish = sl::utils::current_time_millis_steady() + conf.timeout_millis;
+            size_t written = this->write_until(dev, data.data(), data.size(), finish);
+            return static_cast<uint32_t>(written);
+        }));
+    }
+
+    uint32_t writev(connection&, const std::vector<sl::io::span<const char>>& segments) {
+        size_t total = 0;
+        for (auto& seg : segments) {
+            total += seg.size();
+        }
+        std::lock_guard<std::mutex> guard{out_mutex};
+        stats_scope scope(counters.write);
+        return scope.done(total, with_device<uint32_t>([this, &segments](opened_device& dev) {
+            return this->writev_device(dev, segments);
+        }));
+    }
+
+    std::string control(connection& frontend, const sl::json::value& control_options) {
+        auto req = prepare_control(frontend, control_options);
+        return execute_control(frontend, req, control_overrides());
+    }
+
+    control_request prepare_control(connection&, const sl::json::value& control_options) {
+        auto req = control_request(control_options);
+        check_control(req, sl::io::make_span(req.data.data(), req.data.length()));
+        return req;
+    }
+
+    std::vector<std::string> transact(connection&, const std::vector<sl::io::span<const char>>& requests,
+            const transaction_options& options) {
+        capture.check_not_captured(std::string());
+        std::lock(out_mutex, in_mutex);
+        std::lock_guard<std::mutex> out_guard{out_mutex, std::adopt_lock};
+        std::lock_guard<std::mutex> in_guard{in_mutex, std::adopt_lock};
+        return transact_loop(requests, options, conf.timeout_millis,
+                [this](const sl::io::span<const char>& req, uint64_t finish) -> bool {
+                    stats_scope scope(counters.write);
+                    size_t written = this->with_device<size_t>([this, &req, finish](opened_device& dev) {
+                        return this->write_until(dev, req.data(), req.size(), finish);
+                    });
+                    return scope.done(req.size(), written) == req.size();
+                },
+                [this, &options](uint32_t timeout_millis) {
+                    stats_scope scope(counters.read);
+                    return scope.done_message(this->read_response(options, timeout_millis));
+                });
+    }
+
+    void check_control(const control_request& req, sl::io::span<const char> data) {
+        if (0 == req.request_type) throw support::exception(TRACEMSG(
+                "Required parameter 'requestType' not specified"));
+        if (0 == req.request) throw support::exception(TRACEMSG(
+                "Required parameter 'request' not specified"));
+        if (data.size() > conf.buffer_size || data.size() > control_max_length) throw support::exception(TRACEMSG(
+                "Invalid parameter 'data', size: [" + sl::support::to_string(data.size()) + "]," +
+                " max size: [" + sl::support::to_string(std::min<size_t>(conf.buffer_size, control_max_length)) + "]"));
+    }
+
+    // http://libusb.sourceforge.net/api-1.0/group__syncio.html#gadb11f7a761bd12fc77a07f4568d56f38
+    std::string execute_control(connection&, const control_request& req, const control_overrides& overrides) {
+        auto data = overrides.data_or(req.data);
+        bool data_specified = req.data_specified || nullptr != overrides.data;
+        check_control(req, data);
+
+        std::lock_guard<std::mutex> guard{control_mutex};
+        stats_scope scope(counters.control);
+        auto res = with_device<std::string>([&](opened_device& dev) -> std::string {
+            // optional reset
+            if (req.reset) {
+                auto err = libusb_reset_device(dev.handle.get());
+                if (0 != err) throw support::exception(TRACEMSG(
+                        "USB 'libusb_reset_device' error, code: [" + sl::support::to_string(err) + "]"));
+            }
+
+            // call device
+            unsigned char* data_pass = nullptr;
+            uint16_t data_pass_len = 0;
+            auto buf = buffers.lease(conf.buffer_size);
+            if (data_specified) {
+                // 'wLength' is 16-bit, larger buffer is only partially used
+                size_t pass_len = data.size() > 0 ? data.size() : std::min(buf.size(), control_max_length);
+                if (data.size() > 0) {
+                    std::memcpy(buf.data(), data.data(), data.size());
+                } else {
+                    // pooled buffer holds data of the previous transfers,
+                    // it must not be sent with OUT requests
+                    std::memset(buf.data(), '\0', pass_len);
+                }
+                data_pass = reinterpret_cast<unsigned char*>(buf.data());
+                data_pass_len = static_cast<uint16_t>(pass_len);
+            }
+            auto transferred = libusb_control_transfer(
+                    dev.handle.get(),
+                    req.request_type,
+                    req.request,
+                    overrides.value_or(req.value),
+                    overrides.index_or(req.index),
+                    data_pass,
+                    data_pass_len,
+                    conf.timeout_millis);
+            if (transferred < 0) {
+                counters.control.record_error_code(transferred);
+                throw support::exception(TRACEMSG(
+                        "USB 'libusb_control_transfer' error, code: [" + sl::support::to_string(transferred) + "]"));
+            }
+            return data_specified ? std::string(buf.data(), static_cast<size_t>(transferred)) : std::string();
+        });
+        // response length depends on the request, so control is never partial
+        scope.done(res.length(), res.length());
+        return res;
+    }
+
+    std::shared_ptr<transfer_future> read_async(connection&, uint32_t length) {
+        capture.check_not_captured(std::string());
+        return with_device<std::shared_ptr<transfer_future>>([this, length](opened_device& dev) -> std::shared_ptr<transfer_future> {
+            if (nullptr != dev.read_ahead.get()) throw support::exception(TRACEMSG(
+                    "Async read is not supported when 'readAhead' is enabled"));
+            if (nullptr != dev.iso_in.get()) throw support::exception(TRACEMSG(
+                    "Async read is not supported for 'isochronous' IN endpoint"));
+            auto buf = std::string();
+            buf.resize(length);
+            return dev.async_transfers.submit(dev.handle.get(), static_cast<unsigned char>(conf.in_endpoint),
+                    conf.in_transfer_type, transfer_future::kind::read, std::move(buf), conf.timeout_millis);
+        });
+    }
+
+    // data is copied, caller memory may be released before the transfer completes
+    std::shared_ptr<transfer_future> write_async(connection&, sl::io::span<const char> data) {
+        return with_device<std::shared_ptr<transfer_future>>([this, &data](opened_device& dev) -> std::shared_ptr<transfer_future> {
+            if (nullptr != dev.iso_out.get()) throw support::exception(TRACEMSG(
+                    "Async write is not supported for 'isochronous' OUT endpoint"));
+            auto buf = std::string(data.data(), data.size());
+            return dev.async_transfers.submit(dev.handle.get(), static_cast<unsigned char>(conf.out_endpoint),
+                    conf.out_transfer_type, transfer_future::kind::write, std::move(buf), conf.timeout_millis);
+        });
+    }
 
-    std::string read(connection&, uint32_t length) {
+    sl::json::value write_file(connection&, const sl::json::value& file_write_options_json) {
+        auto options = file_write_options(file_write_options_json);
+        mapped_file file(options.path);
+        std::lock_guard<std::mutex> guard{out_mutex};
+        // not repeated on reconnect, part of the file may be already written
+        auto dev = current_device();
+        if (nullptr != dev->iso_out.get()) throw support::exception(TRACEMSG(
+                "File write is not supported for 'isochronous' OUT endpoint"));
+        auto ha = dev->handle.get();
+        size_t packet = static_cast<size_t>(max_packet_size(ha, conf.out_endpoint));
+        size_t chunk = std::max(packet, options.chunk_size - options.chunk_size % packet);
+        // device cannot tell the end of the data, that ends on the packet boundary
+        bool zlp = options.zero_length_packet && 0 == file.size() % packet;
+        uint32_t timeout = options.timeout_millis > 0 ? options.timeout_millis : conf.timeout_millis;
+        file_progress.begin(options.path, file.size());
+        auto deferred = sl::support::defer([this]() STATICLIB_NOEXCEPT {
+            file_progress.end();
+        });
+        out_pipeline_libusb pipeline(ha, static_cast<unsigned char>(conf.out_endpoint), conf.out_transfer_type,
+                options.transfers, static_cast<unsigned int>(timeout), file_progress);
         uint64_t start = sl::utils::current_time_millis_steady();
-        uint64_t finish = start + conf.timeout_millis;
+        pipeline.run(file.data(), file.size(), chunk, zlp);
+        return {
+            { "bytesWritten", static_cast<uint64_t>(file.size()) },
+            { "chunkSize", static_cast<uint64_t>(chunk) },
+            { "zeroLengthPacket", zlp },
+            { "elapsedMillis", sl::utils::current_time_millis_steady() - start }
+        };
+    }
+
+    sl::json::value write_file_stats(connection&) {
+        return file_progress.to_json();
+    }
+
+    void capture_start(connection&, const sl::json::value& capture_options_json) {
+        auto options = capture_options(capture_options_json);
+        endpoint_stream* st = nullptr;
+        if (!options.endpoint.empty()) {
+            st = std::addressof(find_stream(options.endpoint));
+            if (0 == st->in_endpoint) throw support::exception(TRACEMSG(
+                    "IN endpoint not specified for endpoint set: [" + options.endpoint + "]"));
+        }
+        // device data is read directly into the mapped segment, locks are
+        // taken per chunk, so other directions are not blocked; capture
+        // transfers are not counted, their errors stop the capture
+        capture.start(std::move(options), conf.buffer_size, conf.timeout_millis,
+                [this, st](char* dest, size_t len, uint32_t poll) -> size_t {
+            if (nullptr == st) {
+                std::lock_guard<std::mutex> guard{in_mutex};
+                if (!frames.empty()) {
+                    // bytes buffered by previous frame reads go first
+                    return frames.take(dest, len);
+                }
+                return with_device<size_t>([this, dest, len, poll](opened_device& dev) {
+                    return this->read_some(dev, dest, len, poll, nullptr);
+                });
+            }
+            std::lock_guard<std::mutex> guard{st->in_mutex};
+            return with_device<size_t>([this, st, dest, len, poll](opened_device& dev) {
+                return this->read_sync(dev, st->in_endpoint, st->in_transfer_type,
+                        dest, static_cast<uint32_t>(len), poll, nullptr);
+            });
+        });
+    }
+
+    sl::json::value capture_stop(connection&) {
+        return capture.stop();
+    }
+
+    sl::json::value stats(connection&, bool reset) {
+        return counters.to_json(reset);
+    }
+
+    static void initialize() {
+        shared_context();
+    }
+
+private:
+    std::shared_ptr<opened_device> current_device() {
+        std::lock_guard<std::mutex> guard{device_mutex};
+        return device;
+    }
+
+    // with 'autoReconnect' enabled, operation that failed because the device
+    // was detached is repeated once on the re-attached device
+    template<typename Result, typename Fun>
+    Result with_device(Fun fun) {
+        auto dev = current_device();
+        try {
+            return fun(*dev);
+        } catch (const std::exception&) {
+            if (!conf.auto_reconnect || shared_context().devices().contains(libusb_get_device(dev->handle.get()))) {
+                throw;
+            }
+        }
+        return fun(*reconnect(dev));
+    }
+
+    // 'device_mutex' is not held while waiting, so operations that do not
+    // need the detached device are not blocked by the reconnect
+    std::shared_ptr<opened_device> reconnect(const std::shared_ptr<opened_device>& failed) {
+        std::lock_guard<std::mutex> guard{reconnect_mutex};
+        auto& index = shared_context().devices();
+        uint64_t finish = sl::utils::current_time_millis_steady() + conf.timeout_millis;
+        for (;;) {
+            auto current = current_device();
+            if (current.get() != failed.get()) {
+                // already reconnected from another operation
+                return current;
+            }
+            uint64_t gen = index.generation();
+            auto ha = try_open(conf);
+            if (nullptr != ha) {
+                auto opened = setup_device(ha, nullptr, claimed_interfaces(conf, std::vector<int>()));
+                std::lock_guard<std::mutex> device_guard{device_mutex};
+                this->device = opened;
+                return opened;
+            }
+            uint64_t cur = sl::utils::current_time_millis_steady();
+            if (cur >= finish) throw support::exception(TRACEMSG(
+                    "USB device with VID: [" + tohex(conf.vendor_id) + "], PID: [" + tohex(conf.product_id) + "]" +
+                    " was detached and has not re-appeared in: [" + sl::support::to_string(conf.timeout_millis) + "] ms"));
+            index.wait_arrival(gen, static_cast<uint32_t>(finish - cur));
+        }
+    }
+
+    // serial number of the pooled handle is read here, if it is not known from the pool
+    std::shared_ptr<opened_device> setup_device(libusb_device_handle* ha, const std::string* known_serial,
+            std::vector<int> interfaces) {
+        auto dev = std::shared_ptr<opened_device>();
+        if (conf.pooled) {
+            uint16_t vid = conf.vendor_id;
+            uint16_t pid = conf.product_id;
+            uint32_t idle_timeout = conf.pool_idle_timeout_millis;
+            auto serial = nullptr != known_serial ? *known_serial : read_serial(ha);
+            dev = std::make_shared<opened_device>(ha, [vid, pid, idle_timeout, serial, interfaces](libusb_device_handle* ha) {
+                auto pooled = pooled_handle();
+                pooled.handle = ha;
+                pooled.serial = serial;
+                pooled.interfaces = interfaces;
+                shared_context().handles().give_back(vid, pid, std::move(pooled), idle_timeout);
+            });
+        } else {
+            dev = std::make_shared<opened_device>(ha, [interfaces](libusb_device_handle* ha) {
+                handle_pool_libusb::close_handle(ha, interfaces);
+            });
+        }
+        if (transfer_type::isochronous == conf.in_transfer_type) {
+            if (conf.read_ahead.enabled()) throw support::exception(TRACEMSG(
+                    "'readAhead' is not supported for 'isochronous' IN endpoint"));
+            auto& iso = conf.isochronous;
+            uint32_t packet_size = iso_packet_size(ha, conf.in_endpoint);
+            uint32_t ring_packets = iso.ring_packets_for(packet_size);
+            dev->iso_in = sl::support::make_unique<iso_in_stream_libusb>(ha,
+                    static_cast<unsigned char>(conf.in_endpoint), iso.packets_per_transfer,
+                    iso.transfers, packet_size, ring_packets);
+        }
+        if (transfer_type::isochronous == conf.out_transfer_type) {
+            auto& iso = conf.isochronous;
+            dev->iso_out = sl::support::make_unique<iso_out_stream_libusb>(ha,
+                    static_cast<unsigned char>(conf.out_endpoint), iso.packets_per_transfer,
+                    iso.transfers, iso_packet_size(ha, conf.out_endpoint));
+        }
+        if (conf.read_ahead.enabled()) {
+            auto& ra = conf.read_ahead;
+            uint32_t transfer_size = ra.transfer_size;
+            if (0 == transfer_size) {
+                // every interrupt report completes its own transfer
+                transfer_size = transfer_type::interrupt == conf.in_transfer_type ?
+                        static_cast<uint32_t>(max_packet_size(ha, conf.in_endpoint)) : 16384;
+            }
+            uint64_t ring_size_wide = ra.ring_size > 0 ? ra.ring_size :
+                    static_cast<uint64_t>(ra.transfers) * transfer_size * 4;
+            if (ring_size_wide > read_ahead_max_ring_size) throw support::exception(TRACEMSG(
+                    "Invalid 'readAhead' ring size: [" + sl::support::to_string(ring_size_wide) + "]," +
+                    " max size: [" + sl::support::to_string(read_ahead_max_ring_size) + "]," +
+                    " 'transfers' or 'transferSize' must be reduced, or 'ringSize' specified"));
+            uint32_t ring_size = static_cast<uint32_t>(ring_size_wide);
+            if (ring_size < transfer_size) throw support::exception(TRACEMSG(
+                    "Invalid 'readAhead.ringSize' field: [" + sl::support::to_string(ring_size) + "]," +
+                    " must be not less than transfer size: [" + sl::support::to_string(transfer_size) + "]"));
+            dev->read_ahead = sl::support::make_unique<read_ahead_libusb>(ha,
+                    static_cast<unsigned char>(conf.in_endpoint), conf.in_transfer_type,
+                    ra.transfers, transfer_size, ring_size);
+        }
+        return dev;
+    }
+
+    endpoint_stream& find_stream(const std::string& name) {
+        auto it = streams.find(name);
+        if (streams.end() == it) throw support::exception(TRACEMSG(
+                "Invalid endpoint set name specified: [" + name + "]"));
+        return *it->second;
+    }
+
+    // called under 'in_mutex', empty result means timeout
+    std::string read_response(const transaction_options& options, uint32_t timeout_millis) {
+        if (options.framed) {
+            return frames.read_frame(options.framing, timeout_millis, conf.buffer_size,
+                    [this](char* dest, size_t chunk, uint32_t remaining_millis) {
+                return this->with_device<size_t>([this, dest, chunk, remaining_millis](opened_device& dev) {
+                    return this->read_some(dev, dest, chunk, remaining_millis, std::addressof(counters.read));
+                });
+            });
+        }
+        auto res = std::string();
+        res.resize(options.response_length);
+        size_t got = frames.take(std::addressof(res.front()), res.length());
+        if (got < res.length()) {
+            char* ptr = std::addressof(res.front()) + got;
+            uint32_t remaining = static_cast<uint32_t>(res.length() - got);
+            got += with_device<size_t>([this, ptr, remaining, timeout_millis](opened_device& dev) {
+                return this->read_device(dev, ptr, remaining, timeout_millis);
+            });
+        }
+        res.resize(got);
+        return res;
+    }
+
+    size_t read_device(opened_device& dev, char* dest, uint32_t length, uint32_t timeout_millis) {
+        auto& rc = conf.read_completion;
+        uint32_t min_length = rc.min_length_for(length);
+        if (nullptr != dev.read_ahead.get()) {
+            return dev.read_ahead->read(dest, length, min_length, timeout_millis, rc.idle_timeout_millis);
+        }
+        if (nullptr != dev.iso_in.get()) {
+            return dev.iso_in->read(dest, length, min_length, timeout_millis, rc.idle_timeout_millis);
+        }
+        return read_sync(dev, conf.in_endpoint, conf.in_transfer_type, dest, length, timeout_millis,
+                std::addressof(counters.read));
+    }
+
+    // synchronous bulk or interrupt read with 'readCompletion' rules,
+    // error codes go to 'stats' of the operation, if it is counted
+    size_t read_sync(opened_device& dev, uint32_t endpoint, transfer_type ttype, char* dest,
+            uint32_t length, uint32_t timeout_millis, operation_stats* stats) {
+        auto& rc = conf.read_completion;
+        uint32_t min_length = rc.min_length_for(length);
+        uint64_t start = sl::utils::current_time_millis_steady();
+        uint64_t finish = start + timeout_millis;
         uint64_t cur = start;
-        std::string res;
+        size_t got = 0;
         for (;;) {
-            auto prev_len = res.length();
-            res.resize(length);
             uint32_t passed = static_cast<uint32_t> (cur - start);
+            uint32_t tm = timeout_millis - passed;
+            // idle interval is counted between transfers, after the first byte
+            bool idle = got > 0 && rc.idle_timeout_millis > 0 && rc.idle_timeout_millis < tm;
+            if (idle) {
+                tm = rc.idle_timeout_millis;
+            }
+            int requested = static_cast<int>(length - got);
             int read = -1;
-            int err = libusb_bulk_transfer(
-                    handle.get(),
-                    conf.in_endpoint,
-                    reinterpret_cast<unsigned char*>(std::addressof(res.front()) + prev_len),
-                    static_cast<int>(length - prev_len),
+            int err = sync_transfer(
+                    dev,
+                    endpoint,
+                    ttype,
+                    reinterpret_cast<unsigned char*>(dest + got),
+                    requested,
                     std::addressof(read),
-                    static_cast<unsigned int>(conf.timeout_millis - passed));
+                    static_cast<unsigned int>(tm),
+                    stats);
             if (LIBUSB_ERROR_TIMEOUT != err && (LIBUSB_SUCCESS != err || -1 == read)) {
                 throw support::exception(TRACEMSG(
-                        "USB 'libusb_bulk_transfer' error, code: [" + sl::support::to_string(err) + "]"));
+                        "USB '" + transfer_fun_name(ttype) + "' error," +
+                        " code: [" + sl::support::to_string(err) + "]"));
+            }
+            // on timeout, data received before it is kept
+            if (read > 0) {
+                got += static_cast<size_t>(read);
             }
             if (LIBUSB_ERROR_TIMEOUT != err) {
-                res.resize(prev_len + read);
-                if (res.length() >= length) {
+                if (got >= min_length) {
+                    break;
+                }
+                // transfer, that is completed before all requested bytes
+                // are received, is ended by a short or zero-length packet
+                if (rc.short_packet && read < requested) {
                     break;
                 }
-            } else { // read timeout
-                res.resize(prev_len);
+            } else if (idle) {
+                break;
             }
             cur = sl::utils::current_time_millis_steady();
             if (cur >= finish) {
                 break;
             }
         }
-        return res;
+        return got;
     }
 
-    uint32_t write(connection&, sl::io::span<const char> data) {
-        uint64_t start = sl::utils::current_time_millis_steady();
-        uint64_t finish = start + conf.timeout_millis;
-        uint64_t cur = start;
-        auto data_mut = std::string();
-        data_mut.resize(data.size());
-        std::memcpy(std::addressof(data_mut.front()), data.data(), data.size());
+    // returns whatever arrives first, up to 'length' bytes
+    size_t read_some(opened_device& dev, char* dest, size_t length, uint32_t timeout_millis,
+            operation_stats* stats) {
+        uint32_t chunk = static_cast<uint32_t>(length);
+        if (nullptr != dev.read_ahead.get()) {
+            return dev.read_ahead->read(dest, chunk, 1, timeout_millis);
+        }
+        if (nullptr != dev.iso_in.get()) {
+            return dev.iso_in->read(dest, chunk, 1, timeout_millis);
+        }
+        uint64_t finish = sl::utils::current_time_millis_steady() + timeout_millis;
+        for (;;) {
+            uint64_t cur = sl::utils::current_time_millis_steady();
+            if (cur >= finish) {
+                return 0;
+            }
+            int read = -1;
+            int err = sync_transfer(
+                    dev,
+                    conf.in_endpoint,
+                    conf.in_transfer_type,
+                    reinterpret_cast<unsigned char*>(dest),
+                    static_cast<int>(chunk),
+                    std::addressof(read),
+                    static_cast<unsigned int>(finish - cur),
+                    stats);
+            if (LIBUSB_ERROR_TIMEOUT != err && (LIBUSB_SUCCESS != err || -1 == read)) {
+                throw support::exception(TRACEMSG(
+                        "USB '" + transfer_fun_name(conf.in_transfer_type) + "' error," +
+                        " code: [" + sl::support::to_string(err) + "]"));
+            }
+            // data received before the timeout is kept
+            if (read > 0) {
+                return static_cast<size_t>(read);
+            }
+        }
+    }
+
+    // segments are sent as a single logical transfer: only the parts of segments,
+    // that do not fill a whole max-size packet, are staged into the small
+    // buffer, everything else goes to the device directly from the caller memory,
+    // so segment boundaries never produce short packets in the middle of the stream
+    uint32_t writev_device(opened_device& dev, const std::vector<sl::io::span<const char>>& segments) {
+        uint64_t finish = sl::utils::current_time_millis_steady() + conf.timeout_millis;
+        if (nullptr != dev.iso_out.get()) {
+            // stream is already split into packets by the ISO transfers
+            size_t written = 0;
+            for (auto& seg : segments) {
+                size_t wr = dev.iso_out->write(seg.data(), seg.size(), finish);
+                written += wr;
+                if (wr < seg.size()) {
+                    break;
+                }
+            }
+            return static_cast<uint32_t>(written);
+        }
+        size_t packet_size = static_cast<size_t>(max_packet_size(dev.handle.get(), conf.out_endpoint));
+        auto stage = buffers.lease(packet_size);
+        size_t staged = 0;
+        size_t written = 0;
+        for (auto& seg : segments) {
+            const char* ptr = seg.data();
+            size_t len = seg.size();
+            if (staged > 0) {
+                size_t fill = std::min(packet_size - staged, len);
+                std::memcpy(stage.data() + staged, ptr, fill);
+                staged += fill;
+                ptr += fill;
+                len -= fill;
+                if (staged < packet_size) {
+                    continue;
+                }
+                size_t wr = write_until(dev, stage.data(), staged, finish);
+                written += wr;
+                staged = 0;
+                if (wr < packet_size) {
+                    return static_cast<uint32_t>(written);
+                }
+            }
+            size_t direct = (len / packet_size) * packet_size;
+            if (direct > 0) {
+                size_t wr = write_until(dev, ptr, direct, finish);
+                written += wr;
+                if (wr < direct) {
+                    return static_cast<uint32_t>(written);
+                }
+            }
+            if (len > direct) {
+                std::memcpy(stage.data(), ptr + direct, len - direct);
+                staged = len - direct;
+            }
+        }
+        if (staged > 0) {
+            written += write_until(dev, stage.data(), staged, finish);
+        }
+        return static_cast<uint32_t>(written);
+    }
+
+    size_t write_until(opened_device& dev, const char* data, size_t data_len, uint64_t finish) {
+        if (nullptr != dev.iso_out.get()) {
+            return dev.iso_out->write(data, data_len, finish);
+        }
+        return write_sync(dev, conf.out_endpoint, conf.out_transfer_type, data, data_len, finish);
+    }
+
+    // libusb does not modify the OUT buffer, so caller memory is passed as is
+    size_t write_sync(opened_device& dev, uint32_t endpoint, transfer_type ttype, const char* data,
+            size_t data_len, uint64_t finish) {
         size_t written = 0;
         for(;;) {
-            uint32_t passed = static_cast<uint32_t> (cur - start);
+            uint64_t cur = sl::utils::current_time_millis_steady();
+            if (cur >= finish) {
+                break;
+            }
             int wr = -1;
-            auto wlen = data.size() - written;
-            auto packet = reinterpret_cast<unsigned char*>(std::addressof(data_mut.front()) + written);
-            int err = libusb_bulk_transfer(
-                    handle.get(),
-                    conf.out_endpoint,
+            auto packet = reinterpret_cast<unsigned char*>(const_cast<char*>(data + written));
+            int err = sync_transfer(
+                    dev,
+                    endpoint,
+                    ttype,
                     packet,
-                    static_cast<int>(wlen),
+                    static_cast<int>(data_len - written),
                     std::addressof(wr),
-                    static_cast<unsigned int>(conf.timeout_millis - passed));
+                    static_cast<unsigned int>(finish - cur),
+                    std::addressof(counters.write));
             if (0 != err || -1 == wr) {
                 throw support::exception(TRACEMSG(
-                        "USB 'libusb_bulk_transfer' error, code: [" + sl::support::to_string(err) + "]"));
+                        "USB '" + transfer_fun_name(ttype) + "' error," +
+                        " code: [" + sl::support::to_string(err) + "]"));
             }
             written += static_cast<size_t>(wr);
-            if (written >= data.size()) {
+            if (written >= data_len) {
                 break;
             }
-            cur = sl::utils::current_time_millis_steady();
-            if (cur >= finish) {
-                break;
+        }
+        return written;
+    }
+
+    // timeouts are not errors here, they are counted by the operations
+    int sync_transfer(opened_device& dev, uint32_t endpoint, transfer_type ttype, unsigned char* data,
+            int length, int* transferred, unsigned int timeout, operation_stats* stats) {
+        int err = transfer_type::interrupt == ttype ?
+                libusb_interrupt_transfer(dev.handle.get(), static_cast<unsigned char>(endpoint),
+                        data, length, transferred, timeout) :
+                libusb_bulk_transfer(dev.handle.get(), static_cast<unsigned char>(endpoint),
+                        data, length, transferred, timeout);
+        if (nullptr != stats && LIBUSB_SUCCESS != err && LIBUSB_ERROR_TIMEOUT != err) {
+            stats->record_error_code(err);
+        }
+        return err;
+    }
+
+    static std::string transfer_fun_name(transfer_type ttype) {
+        return transfer_type::interrupt == ttype ? "libusb_interrupt_transfer" : "libusb_bulk_transfer";
+    }
+
+    // configured size is checked against the endpoint limit
+    uint32_t iso_packet_size(libusb_device_handle* ha, uint32_t endpoint) {
+        auto size = libusb_get_max_iso_packet_size(libusb_get_device(ha),
+                static_cast<unsigned char>(endpoint));
+        if (size <= 0) throw support::exception(TRACEMSG(
+                "USB 'libusb_get_max_iso_packet_size' error, code: [" + sl::support::to_string(size) + "]"));
+        uint32_t configured = conf.isochronous.packet_size;
+        if (configured > static_cast<uint32_t>(size)) throw support::exception(TRACEMSG(
+                "Invalid 'isochronous.packetSize' field: [" + sl::support::to_string(configured) + "]," +
+                " endpoint max ISO packet size: [" + sl::support::to_string(size) + "]"));
+        return configured > 0 ? configured : static_cast<uint32_t>(size);
+    }
+
+    static int max_packet_size(libusb_device_handle* ha, uint32_t endpoint) {
+        auto size = libusb_get_max_packet_size(libusb_get_device(ha),
+                static_cast<unsigned char>(endpoint));
+        if (size <= 0) throw support::exception(TRACEMSG(
+                "USB 'libusb_get_max_packet_size' error, code: [" + sl::support::to_string(size) + "]"));
+        return size;
+    }
+
+    static std::vector<sl::json::value> list(const usb_config& conf) {
+        auto res = std::vector<sl::json::value>();
+        for (auto& dev : shared_context().devices().find_all(conf.vendor_id, conf.product_id)) {
+            if (!location_matches(dev.get(), conf)) {
+                continue;
+            }
+            auto serial = std::string();
+            libusb_device_handle* ha = nullptr;
+            if (LIBUSB_SUCCESS == libusb_open(dev.get(), std::addressof(ha))) {
+                serial = read_serial(ha);
+                libusb_close(ha);
+            }
+            if (!conf.serial_number.empty() && serial != conf.serial_number) {
+                continue;
             }
+            res.emplace_back(sl::json::value({
+                { "busNumber", static_cast<int32_t>(libusb_get_bus_number(dev.get())) },
+                { "portPath", port_path(dev.get()) },
+                { "serialNumber", serial }
+            }));
         }
-        return static_cast<uint32_t>(written);
+        return res;
     }
 
-    // http://libusb.sourceforge.net/api-1.0/group__syncio.html#gadb11f7a761bd12fc77a07f4568d56f38
-    std::string control(connection&, const sl::json::value& control_options) {
-        // parse options
-        uint8_t request_type = 0;
-        uint8_t request = 0;
-        uint16_t value = 0;
-        uint16_t index = 0;
-        auto rdata = std::ref(sl::utils::empty_string());
-        auto rdatahex = std::ref(sl::utils::empty_string());
-        bool data_specified = true;
-        bool reset = false;
-        for (const sl::json::field& fi : control_options.as_object()) {
-            auto& name = fi.name();
-            if ("requestType" == name) {
-                request_type = fi.as_uint16_positive_or_throw(name);
-            } else if ("request" == name) {
-                request = fi.as_uint16_positive_or_throw(name);
-            } else if ("value" == name) {
-                value = fi.as_uint16_or_throw(name);
-            } else if ("index" == name) {
-                index = fi.as_uint16_or_throw(name);
-            } else if ("data" == name) {
-                if (sl::json::type::nullt == fi.json_type()) {
-                    data_specified = false;
-                } else {
-                    rdata = fi.as_string_nonempty_or_throw(name);
-                }
-            } else if ("dataHex" == name) {
-                rdatahex = fi.as_string_nonempty_or_throw(name);
-            } else if ("reset" == name) {
-                reset = fi.as_bool_or_throw(name);
-            } else {
-                throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+    static bool location_matches(libusb_device* dev, const usb_config& conf) {
+        if (-1 != conf.bus_number && conf.bus_number != static_cast<int32_t>(libusb_get_bus_number(dev))) {
+            return false;
+        }
+        return conf.port_path.empty() || conf.port_path == port_path(dev);
+    }
+
+    // port numbers from the root hub separated with dots, e.g. '1.4.2'
+    static std::string port_path(libusb_device* dev) {
+        std::array<uint8_t, 8> ports;
+        int count = libusb_get_port_numbers(dev, ports.data(), static_cast<int>(ports.size()));
+        auto res = std::string();
+        for (int i = 0; i < count; i++) {
+            if (i > 0) {
+                res.push_back('.');
             }
+            res.append(sl::support::to_string(static_cast<uint32_t>(ports[static_cast<size_t>(i)])));
         }
-        if (0 == request_type) throw support::exception(TRACEMSG(
-                "Required parameter 'requestType' not specified"));
-        if (0 == request) throw support::exception(TRACEMSG(
-                "Required parameter 'request' not specified"));
-        if (rdata.get().length() > conf.buffer_size) throw support::exception(TRACEMSG(
-                "Invalid parameter 'data', size: [" + sl::support::to_string(rdata.get().size()) + "]"));
-        if (rdatahex.get().length() > conf.buffer_size) throw support::exception(TRACEMSG(
-                "Invalid parameter 'dataHex', size: [" + sl::support::to_string(rdatahex.get().size()) + "]"));
-
-        // optional reset
-        if (reset) {
-            auto err = libusb_reset_device(handle.get());
-            if (0 != err) support::exception(TRACEMSG(
-                    "USB 'libusb_reset_device' error, code: [" + sl::support::to_string(err) + "]"));
-        }
-
-        // call device
-        unsigned char* data_pass = nullptr;
-        uint16_t data_pass_len = 0;
-        auto data = std::string();
-        auto buf = std::string();
-        if (data_specified) {
-            data = !rdata.get().empty() ? rdata.get() : sl::io::string_from_hex(rdatahex.get());
-            buf.resize(conf.buffer_size);
-            if (!data.empty()) {
-                std::memcpy(std::addressof(buf.front()), data.data(), data.length());
-            }
-            data_pass = reinterpret_cast<unsigned char*>(std::addressof(buf.front()));
-            data_pass_len = !data.empty() ? data.length() : buf.length();
-        }
-        auto transferred = libusb_control_transfer(
-                handle.get(),
-                static_cast<uint8_t> (request_type),
-                static_cast<uint8_t> (request),
-                value,
-                index,
-                data_pass,
-                data_pass_len,
-                conf.timeout_millis);
-        if (transferred < 0) {
-            throw support::exception(TRACEMSG(
-                    "USB 'libusb_control_transfer' error, code: [" + sl::support::to_string(transferred) + "]"));
+        return res;
+    }
+
+    // empty string if device has no serial number
+    static std::string read_serial(libusb_device_handle* ha) {
+        struct libusb_device_descriptor desc;
+        auto err_desc = libusb_get_device_descriptor(libusb_get_device(ha), std::addressof(desc));
+        if (LIBUSB_SUCCESS != err_desc || 0 == desc.iSerialNumber) {
+            return std::string();
+        }
+        std::array<unsigned char, 256> buf;
+        int len = libusb_get_string_descriptor_ascii(ha, desc.iSerialNumber, buf.data(), static_cast<int>(buf.size()));
+        if (len <= 0) {
+            return std::string();
         }
-        return data_specified ? data.substr(0, transferred) : std::string();
+        return std::string(reinterpret_cast<const char*>(buf.data()), static_cast<size_t>(len));
     }
 
-    static void initialize() {
-        shared_context();
+    // handles of detached devices are not leased
+    static pooled_handle lease_pooled(const usb_config& conf) {
+        auto& ctx = shared_context();
+        return ctx.handles().lease(conf.vendor_id, conf.product_id, [&ctx, &conf](const pooled_handle& ph) {
+            auto dev = libusb_get_device(ph.handle);
+            return ctx.devices().contains(dev) && location_matches(dev, conf) &&
+                    (conf.serial_number.empty() || conf.serial_number == ph.serial);
+        });
     }
 
-private:
-    static libusb_device_handle* find_and_open_by_vid_pid(uint16_t vid, uint16_t pid) {
-        auto ctx = shared_context();
-        struct libusb_device **devlist = nullptr;
-        auto err_getlist = libusb_get_device_list(ctx.get(), std::addressof(devlist));
-        if (err_getlist < 0) {
+    static libusb_device_handle* find_and_open(const usb_config& conf) {
+        auto ha = try_open(conf);
+        if (nullptr == ha) {
             throw support::exception(TRACEMSG(
-                    "USB 'libusb_get_device_list' error, code: [" + sl::support::to_string(err_getlist) + "]"));
+                    "Cannot find USB device with VID: [" + tohex(conf.vendor_id) + "]," +
+                    " PID: [" + tohex(conf.product_id) + "]," + print_selectors(conf) +
+                    " found devices [" + print_vid_pid_list(shared_context().devices().list()) + "]"));
         }
-        auto deferred = sl::support::defer([devlist] () STATICLIB_NOEXCEPT {
-            libusb_free_device_list(devlist, 1);
-        });
-        size_t devlist_size = static_cast<size_t>(err_getlist);
+        return ha;
+    }
 
-        std::vector<std::pair<uint16_t, uint16_t>> vid_pid_list;
-        for (size_t i = 0; i < devlist_size; i++) {
-            struct libusb_device_descriptor desc;
-            auto err_desc = libusb_get_device_descriptor(devlist[i], std::addressof(desc));
-            if (LIBUSB_SUCCESS != err_desc) {
-                throw support::exception(TRACEMSG(
-                        "USB 'libusb_get_device_descriptor' error, code: [" + sl::support::to_string(err_desc) + "]"));
+    // returns 'nullptr' if there is no matching device, devices that cannot
+    // be opened are skipped, error is thrown only if none of them was opened
+    static libusb_device_handle* try_open(const usb_config& conf) {
+        auto open_error = std::string();
+        for (auto& dev : shared_context().devices().find_all(conf.vendor_id, conf.product_id)) {
+            if (!location_matches(dev.get(), conf)) {
+                continue;
+            }
+            if (conf.serial_number.empty()) {
+                try {
+                    return open_device(dev.get(), conf);
+                } catch (const std::exception& e) {
+                    open_error = e.what();
+                    continue;
+                }
+            }
+            // serial number can only be read from the opened device
+            libusb_device_handle* ha = nullptr;
+            if (LIBUSB_SUCCESS != libusb_open(dev.get(), std::addressof(ha))) {
+                continue;
             }
-            vid_pid_list.emplace_back(desc.idVendor, desc.idProduct);
-            if (desc.idVendor == vid && desc.idProduct == pid) {
-                return open_device(devlist[i]);
+            if (conf.serial_number == read_serial(ha)) {
+                claim_or_close(ha, conf, std::vector<int>());
+                return ha;
             }
+            libusb_close(ha);
         }
-        throw support::exception(TRACEMSG(
-                "Cannot find USB device with VID: [" + tohex(vid) + "], PID: [" + tohex(pid) + "],"
-                " found devices [" + print_vid_pid_list(vid_pid_list) + "]"));
+        if (!open_error.empty()) throw support::exception(TRACEMSG(open_error +
+                "\nNone of the matching USB devices can be opened"));
+        return nullptr;
     }
 
-    static libusb_device_handle* open_device(libusb_device* dev) {
+    static libusb_device_handle* open_device(libusb_device* dev, const usb_config& conf) {
         libusb_device_handle* ha = nullptr;
         // open device
         auto err_open = libusb_open(dev, std::addressof(ha));
@@ -279,29 +1041,74 @@ private:
             throw support::exception(TRACEMSG(
                     "USB 'libusb_open' error, code: [" + sl::support::to_string(err_open) + "]"));
         }
+        claim_or_close(ha, conf, std::vector<int>());
+        return ha;
+    }
+
+    // claims all configured interfaces, claiming already claimed interface is a no-op
+    static void claim_or_close(libusb_device_handle* ha, const usb_config& conf,
+            const std::vector<int>& already_claimed) {
         bool cancel_deferred = false;
-        auto deferred = sl::support::defer([&cancel_deferred, ha] () STATICLIB_NOEXCEPT {
+        auto deferred = sl::support::defer([&cancel_deferred, ha, &conf, &already_claimed] () STATICLIB_NOEXCEPT {
             if (!cancel_deferred) {
-                libusb_close(ha);
+                handle_pool_libusb::close_handle(ha, claimed_interfaces(conf, already_claimed));
             }
         });
-        // detach kernel
-        auto kd_active = libusb_kernel_driver_active(ha, 0);
-        if (kd_active) {
-            auto err = libusb_detach_kernel_driver(ha, 0);
+        for (auto& iface : conf.interfaces) {
+            int num = static_cast<int>(iface.number);
+            // detach kernel
+            auto kd_active = libusb_kernel_driver_active(ha, num);
+            if (1 == kd_active) {
+                auto err = libusb_detach_kernel_driver(ha, num);
+                if (LIBUSB_SUCCESS != err) {
+                    throw support::exception(TRACEMSG(
+                            "USB 'libusb_detach_kernel_driver' error, code: [" + sl::support::to_string(err) + "]," +
+                            " interface: [" + sl::support::to_string(num) + "]"));
+                }
+            }
+            // claim
+            auto err = libusb_claim_interface(ha, num);
             if (LIBUSB_SUCCESS != err) {
                 throw support::exception(TRACEMSG(
-                        "USB 'libusb_detach_kernel_driver' error, code: [" + sl::support::to_string(err) + "]"));
+                        "USB 'libusb_claim_interface' error, code: [" + sl::support::to_string(err) + "]," +
+                        " interface: [" + sl::support::to_string(num) + "]"));
+            }
+            if (iface.alt_setting >= 0) {
+                auto err_alt = libusb_set_interface_alt_setting(ha, num, iface.alt_setting);
+                if (LIBUSB_SUCCESS != err_alt) {
+                    throw support::exception(TRACEMSG(
+                            "USB 'libusb_set_interface_alt_setting' error, code: [" + sl::support::to_string(err_alt) + "]," +
+                            " interface: [" + sl::support::to_string(num) + "]," +
+                            " alt setting: [" + sl::support::to_string(iface.alt_setting) + "]"));
+                }
             }
-        }
-        // claim
-        auto err = libusb_claim_interface(ha, 0); 
-        if (LIBUSB_SUCCESS != err) {
-            throw support::exception(TRACEMSG(
-                    "USB 'libusb_claim_interface' error, code: [" + sl::support::to_string(err) + "]"));
         }
         cancel_deferred = true;
-        return ha;
+    }
+
+    // numbers of the configured interfaces added to the ones claimed before
+    static std::vector<int> claimed_interfaces(const usb_config& conf, std::vector<int> claimed) {
+        for (auto& iface : conf.interfaces) {
+            int num = static_cast<int>(iface.number);
+            if (claimed.end() == std::find(claimed.begin(), claimed.end(), num)) {
+                claimed.push_back(num);
+            }
+        }
+        return claimed;
+    }
+
+    static std::string print_selectors(const usb_config& conf) {
+        auto res = std::string();
+        if (!conf.serial_number.empty()) {
+            res.append(" serial number: [" + conf.serial_number + "],");
+        }
+        if (-1 != conf.bus_number) {
+            res.append(" bus number: [" + sl::support::to_string(conf.bus_number) + "],");
+        }
+        if (!conf.port_path.empty()) {
+            res.append(" port path: [" + conf.port_path + "],");
+        }
+        return res;
     }
 
     static std::string print_vid_pid_list(const std::vector<std::pair<uint16_t, uint16_t>>& list) {
@@ -323,8 +1130,25 @@ private:
 };
 PIMPL_FORWARD_CONSTRUCTOR(connection, (usb_config&&), (), support::exception)
 PIMPL_FORWARD_METHOD(connection, std::string, read, (uint32_t), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, read_into, (sl::io::span<char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_frame, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_frame, (const frame_spec&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_endpoint, (const std::string&)(uint32_t), (), support::exception)
 PIMPL_FORWARD_METHOD(connection, uint32_t, write, (sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, write_endpoint, (const std::string&)(sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, writev, (const std::vector<sl::io::span<const char>>&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::vector<std::string>, transact, (const std::vector<sl::io::span<const char>>&)(const transaction_options&), (), support::exception)
 PIMPL_FORWARD_METHOD(connection, std::string, control, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, control_request, prepare_control, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, execute_control, (const control_request&)(const control_overrides&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::shared_ptr<transfer_future>, read_async, (uint32_t), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::shared_ptr<transfer_future>, write_async, (sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, write_file, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, write_file_stats, (), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, void, capture_start, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, capture_stop, (), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, stats, (bool), (), support::exception)
+PIMPL_FORWARD_METHOD_STATIC(connection, std::vector<sl::json::value>, list, (const usb_config&), (), support::exception)
 PIMPL_FORWARD_METHOD_STATIC(connection, void, initialize, (), (), support::exception)
 
 } // namespace
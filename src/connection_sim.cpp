@@ -0,0 +1,592 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   connection_sim.cpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:32 AM
+ */
+
+#include "connection.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "staticlib/json.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/pimpl/forward_macros.hpp"
+#include "staticlib/utils.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "capture_options.hpp"
+#include "capture_runner.hpp"
+#include "file_write_options.hpp"
+#include "file_write_progress.hpp"
+#include "frame_reader.hpp"
+#include "mapped_file_posix.hpp"
+#include "transact_loop.hpp"
+#include "transfer_stats.hpp"
+
+namespace wilton {
+namespace usb {
+
+namespace { // anonymous
+
+// OUT data of the simulated endpoint pair, that is waiting to be read back
+class sim_pipe {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::string> transfers;
+    // consumed from the front transfer
+    size_t head = 0;
+
+public:
+    sim_pipe() { }
+
+    sim_pipe(const sim_pipe&) = delete;
+
+    sim_pipe& operator=(const sim_pipe&) = delete;
+
+    void push(const char* data, size_t len) {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            transfers.emplace_back(data, len);
+        }
+        cv.notify_all();
+    }
+
+    // returns zero on timeout, with 'single_transfer' stops at the transfer boundary
+    size_t pop(char* dest, size_t len, uint32_t timeout_millis, bool single_transfer) {
+        std::unique_lock<std::mutex> lock{mutex};
+        bool ready = cv.wait_for(lock, std::chrono::milliseconds(timeout_millis), [this] {
+            return !transfers.empty();
+        });
+        if (!ready) {
+            return 0;
+        }
+        size_t got = 0;
+        while (got < len && !transfers.empty()) {
+            auto& front = transfers.front();
+            size_t count = std::min(len - got, front.length() - head);
+            std::memcpy(dest + got, front.data() + head, count);
+            got += count;
+            head += count;
+            if (head == front.length()) {
+                transfers.pop_front();
+                head = 0;
+                if (single_transfer) {
+                    break;
+                }
+            }
+        }
+        return got;
+    }
+};
+
+// named endpoint pair, used independently from the main endpoints
+struct sim_stream {
+    bool has_in;
+    bool has_out;
+    sim_pipe pipe;
+    // 'source' mode data pattern, guarded by 'in_mutex'
+    uint8_t source_counter = 0;
+    std::mutex in_mutex;
+    std::mutex out_mutex;
+
+    sim_stream(const endpoint_set_config& es) :
+    has_in(0 != es.in_endpoint),
+    has_out(0 != es.out_endpoint) { }
+
+    sim_stream(const sim_stream&) = delete;
+
+    sim_stream& operator=(const sim_stream&) = delete;
+};
+
+// latency, throughput limit and error injection applied to every transfer,
+// error codes are recorded only for the counted operations
+class sim_link {
+    const sim_config& conf;
+    std::mutex rng_mutex;
+    std::mt19937 rng;
+    std::uniform_int_distribution<uint32_t> dist;
+
+public:
+    sim_link(const sim_config& conf) :
+    conf(conf),
+    rng(conf.seed),
+    dist(0, 999999) { }
+
+    sim_link(const sim_link&) = delete;
+
+    sim_link& operator=(const sim_link&) = delete;
+
+    void transfer(const char* fun_name, size_t bytes, operation_stats* stats) {
+        if (conf.errors_per_million > 0) {
+            uint32_t roll = 0;
+            {
+                std::lock_guard<std::mutex> guard{rng_mutex};
+                roll = dist(rng);
+            }
+            if (roll < conf.errors_per_million) {
+                if (nullptr != stats) {
+                    stats->record_error_code(-1);
+                }
+                throw support::exception(TRACEMSG(
+                        "USB '" + std::string(fun_name) + "' error, code: [-1], simulated"));
+            }
+        }
+        uint64_t micros = conf.latency_micros;
+        if (conf.bytes_per_second > 0) {
+            micros += static_cast<uint64_t>(bytes) * 1000000 / conf.bytes_per_second;
+        }
+        if (micros > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(micros));
+        }
+    }
+};
+
+} // namespace
+
+class connection::impl : public staticlib::pimpl::object::impl {
+    usb_config conf;
+
+    sim_link link;
+    sim_pipe pipe;
+    // 'source' mode data pattern, guarded by 'in_mutex'
+    uint8_t source_counter = 0;
+
+    std::mutex in_mutex;
+    std::mutex out_mutex;
+    std::mutex control_mutex;
+
+    // guarded by 'in_mutex'
+    frame_reader frames;
+
+    // created on open and never changed, so lookups are not locked
+    std::map<std::string, std::unique_ptr<sim_stream>> streams;
+
+    capture_runner capture;
+
+    file_write_progress file_progress;
+
+    transfer_stats counters;
+
+public:
+    impl(usb_config&& conf) :
+    conf(std::move(conf)),
+    link(this->conf.simulator) {
+        for (auto& en : this->conf.endpoint_sets) {
+            streams.emplace(en.first, sl::support::make_unique<sim_stream>(en.second));
+        }
+    }
+
+    ~impl() STATICLIB_NOEXCEPT {
+        capture.close();
+    }
+
+    std::string read(connection& frontend, uint32_t length) {
+        auto res = std::string();
+        res.resize(length);
+        uint32_t read = read_into(frontend, sl::io::make_span(std::addressof(res.front()), res.length()));
+        res.resize(read);
+        return res;
+    }
+
+    uint32_t read_into(connection&, sl::io::span<char> dest) {
+        capture.check_not_captured(std::string());
+        std::lock_guard<std::mutex> guard{in_mutex};
+        stats_scope scope(counters.read);
+        size_t got = 0;
+        if (!frames.empty()) {
+            got = frames.take(dest.data(), dest.size());
+            if (got == dest.size()) {
+                return scope.done(dest.size(), static_cast<uint32_t>(got));
+            }
+        }
+        got += read_device(dest.data() + got, dest.size() - got, conf.timeout_millis);
+        return scope.done(dest.size(), static_cast<uint32_t>(got));
+    }
+
+    std::string read_frame(connection& frontend, const sl::json::value& framing) {
+        auto spec = frame_spec(framing);
+        return read_frame(frontend, spec);
+    }
+
+    std::string read_frame(connection&, const frame_spec& spec) {
+        capture.check_not_captured(std::string());
+        std::lock_guard<std::mutex> guard{in_mutex};
+        stats_scope scope(counters.read);
+        return scope.done_message(frames.read_frame(spec, conf.timeout_millis, conf.buffer_size,
+                [this](char* dest, size_t chunk, uint32_t timeout_millis) {
+            return this->read_some(dest, chunk, timeout_millis, std::addressof(counters.read));
+        }));
+    }
+
+    std::string read_endpoint(connection&, const std::string& name, uint32_t length) {
+        auto& st = find_stream(name);
+        if (!st.has_in) throw support::exception(TRACEMSG(
+                "IN endpoint not specified for endpoint set: [" + name + "]"));
+        capture.check_not_captured(name);
+        std::lock_guard<std::mutex> guard{st.in_mutex};
+        stats_scope scope(counters.read);
+        auto res = std::string();
+        res.resize(length);
+        res.resize(scope.done(length, read_stream(st, std::addressof(res.front()), length, conf.timeout_millis,
+                std::addressof(counters.read))));
+        return res;
+    }
+
+    uint32_t write_endpoint(connection&, const std::string& name, sl::io::span<const char> data) {
+        auto& st = find_stream(name);
+        if (!st.has_out) throw support::exception(TRACEMSG(
+                "OUT endpoint not specified for endpoint set: [" + name + "]"));
+        std::lock_guard<std::mutex> guard{st.out_mutex};
+        stats_scope scope(counters.write);
+        link.transfer("libusb_bulk_transfer", data.size(), std::addressof(counters.write));
+        if (sim_mode::source != conf.simulator.mode) {
+            st.pipe.push(data.data(), data.size());
+        }
+        return scope.done(data.size(), static_cast<uint32_t>(data.size()));
+    }
+
+    uint32_t write(connection&, sl::io::span<const char> data) {
+        std::lock_guard<std::mutex> guard{out_mutex};
+        stats_scope scope(counters.write);
+        return scope.done(data.size(), static_cast<uint32_t>(write_device(data.data(), data.size())));
+    }
+
+    // segments are a single logical transfer, that is echoed as a whole
+    uint32_t writev(connection& frontend, const std::vector<sl::io::span<const char>>& segments) {
+        auto joined = std::string();
+        for (auto& seg : segments) {
+            joined.append(seg.data(), seg.size());
+        }
+        return write(frontend, sl::io::make_span(joined.data(), joined.size()));
+    }
+
+    std::string control(connection& frontend, const sl::json::value& control_options) {
+        auto req = prepare_control(frontend, control_options);
+        return execute_control(frontend, req, control_overrides());
+    }
+
+    control_request prepare_control(connection&, const sl::json::value& control_options) {
+        auto req = control_request(control_options);
+        check_control(req, sl::io::make_span(req.data.data(), req.data.length()));
+        return req;
+    }
+
+    std::vector<std::string> transact(connection&, const std::vector<sl::io::span<const char>>& requests,
+            const transaction_options& options) {
+        capture.check_not_captured(std::string());
+        std::lock(out_mutex, in_mutex);
+        std::lock_guard<std::mutex> out_guard{out_mutex, std::adopt_lock};
+        std::lock_guard<std::mutex> in_guard{in_mutex, std::adopt_lock};
+        return transact_loop(requests, options, conf.timeout_millis,
+                [this](const sl::io::span<const char>& req, uint64_t) -> bool {
+                    stats_scope scope(counters.write);
+                    return scope.done(req.size(), this->write_device(req.data(), req.size())) == req.size();
+                },
+                [this, &options](uint32_t timeout_millis) {
+                    stats_scope scope(counters.read);
+                    return scope.done_message(this->read_response(options, timeout_millis));
+                });
+    }
+
+    // same limits as with libusb, 'wLength' is 16-bit
+    void check_control(const control_request& req, sl::io::span<const char> data) {
+        if (0 == req.request_type) throw support::exception(TRACEMSG(
+                "Required parameter 'requestType' not specified"));
+        if (0 == req.request) throw support::exception(TRACEMSG(
+                "Required parameter 'request' not specified"));
+        if (data.size() > conf.buffer_size || data.size() > 0xffff) throw support::exception(TRACEMSG(
+                "Invalid parameter 'data', size: [" + sl::support::to_string(data.size()) + "]," +
+                " max size: [" + sl::support::to_string(std::min<size_t>(conf.buffer_size, 0xffff)) + "]"));
+    }
+
+    // scripted responses are returned for IN requests, OUT requests
+    // return their data the same way as 'libusb_control_transfer' does
+    std::string execute_control(connection&, const control_request& req, const control_overrides& overrides) {
+        auto data = overrides.data_or(req.data);
+        bool data_specified = req.data_specified || nullptr != overrides.data;
+        check_control(req, data);
+
+        std::lock_guard<std::mutex> guard{control_mutex};
+        stats_scope scope(counters.control);
+        link.transfer("libusb_control_transfer", data.size(), std::addressof(counters.control));
+        if (!data_specified) {
+            scope.done(0, 0);
+            return std::string();
+        }
+        if (0 == (req.request_type & 0x80)) {
+            scope.done(data.size(), data.size());
+            return std::string(data.data(), data.size());
+        }
+        uint16_t value = overrides.value_or(req.value);
+        uint16_t index = overrides.index_or(req.index);
+        for (auto& cr : conf.simulator.control_responses) {
+            if (cr.matches(req.request_type, req.request, value, index)) {
+                size_t limit = data.size() > 0 ? data.size() : conf.buffer_size;
+                auto res = cr.data.substr(0, limit);
+                scope.done(res.length(), res.length());
+                return res;
+            }
+        }
+        // LIBUSB_ERROR_PIPE, the same as for the stalled request
+        counters.control.record_error_code(-9);
+        throw support::exception(TRACEMSG(
+                "USB 'libusb_control_transfer' error, code: [-9], simulated"));
+    }
+
+    std::shared_ptr<transfer_future> read_async(connection& frontend, uint32_t length) {
+        auto res = std::make_shared<transfer_future>(transfer_future::kind::read);
+        try {
+            res->complete_read(read(frontend, length));
+        } catch (const std::exception& e) {
+            res->fail(e.what());
+        }
+        return res;
+    }
+
+    std::shared_ptr<transfer_future> write_async(connection& frontend, sl::io::span<const char> data) {
+        auto res = std::make_shared<transfer_future>(transfer_future::kind::write);
+        try {
+            res->complete_write(write(frontend, data));
+        } catch (const std::exception& e) {
+            res->fail(e.what());
+        }
+        return res;
+    }
+
+    // chunks are written one by one, 'transfers' option does not apply
+    sl::json::value write_file(connection&, const sl::json::value& file_write_options_json) {
+        auto options = file_write_options(file_write_options_json);
+        mapped_file file(options.path);
+        std::lock_guard<std::mutex> guard{out_mutex};
+        size_t packet = conf.simulator.max_packet_size;
+        size_t chunk = std::max(packet, options.chunk_size - options.chunk_size % packet);
+        bool zlp = options.zero_length_packet && 0 == file.size() % packet;
+        file_progress.begin(options.path, file.size());
+        auto deferred = sl::support::defer([this]() STATICLIB_NOEXCEPT {
+            file_progress.end();
+        });
+        uint64_t start = sl::utils::current_time_millis_steady();
+        for (size_t offset = 0; offset < file.size(); offset += chunk) {
+            size_t count = std::min(chunk, file.size() - offset);
+            file_progress.set_in_flight(1);
+            write_device(file.data() + offset, count);
+            file_progress.add_written(count);
+        }
+        return {
+            { "bytesWritten", static_cast<uint64_t>(file.size()) },
+            { "chunkSize", static_cast<uint64_t>(chunk) },
+            { "zeroLengthPacket", zlp },
+            { "elapsedMillis", sl::utils::current_time_millis_steady() - start }
+        };
+    }
+
+    sl::json::value write_file_stats(connection&) {
+        return file_progress.to_json();
+    }
+
+    void capture_start(connection&, const sl::json::value& capture_options_json) {
+        auto options = capture_options(capture_options_json);
+        sim_stream* st = nullptr;
+        if (!options.endpoint.empty()) {
+            st = std::addressof(find_stream(options.endpoint));
+            if (!st->has_in) throw support::exception(TRACEMSG(
+                    "IN endpoint not specified for endpoint set: [" + options.endpoint + "]"));
+        }
+        // capture transfers are not counted, same as with libusb
+        capture.start(std::move(options), conf.buffer_size, conf.timeout_millis,
+                [this, st](char* dest, size_t len, uint32_t poll) -> size_t {
+            if (nullptr == st) {
+                std::lock_guard<std::mutex> guard{in_mutex};
+                return !frames.empty() ? frames.take(dest, len) : read_some(dest, len, poll, nullptr);
+            }
+            std::lock_guard<std::mutex> guard{st->in_mutex};
+            return read_stream(*st, dest, len, poll, nullptr);
+        });
+    }
+
+    sl::json::value capture_stop(connection&) {
+        return capture.stop();
+    }
+
+    sl::json::value stats(connection&, bool reset) {
+        return counters.to_json(reset);
+    }
+
+    static std::vector<sl::json::value> list(const usb_config& conf) {
+        auto res = std::vector<sl::json::value>();
+        res.emplace_back(sl::json::value({
+            { "busNumber", 0 },
+            { "portPath", "0" },
+            { "serialNumber", !conf.serial_number.empty() ? conf.serial_number : std::string("SIMULATOR") }
+        }));
+        return res;
+    }
+
+    static void initialize() {
+        // no-op
+    }
+
+private:
+    sim_stream& find_stream(const std::string& name) {
+        auto it = streams.find(name);
+        if (streams.end() == it) throw support::exception(TRACEMSG(
+                "Invalid endpoint set name specified: [" + name + "]"));
+        return *it->second;
+    }
+
+    // called under 'in_mutex', empty result means timeout
+    std::string read_response(const transaction_options& options, uint32_t timeout_millis) {
+        if (options.framed) {
+            return frames.read_frame(options.framing, timeout_millis, conf.buffer_size,
+                    [this](char* dest, size_t chunk, uint32_t remaining_millis) {
+                return this->read_some(dest, chunk, remaining_millis, std::addressof(counters.read));
+            });
+        }
+        auto res = std::string();
+        res.resize(options.response_length);
+        size_t got = frames.take(std::addressof(res.front()), res.length());
+        if (got < res.length()) {
+            got += read_device(std::addressof(res.front()) + got, res.length() - got, timeout_millis);
+        }
+        res.resize(got);
+        return res;
+    }
+
+    // called under 'in_mutex', 'readCompletion' rules are applied
+    size_t read_device(char* dest, size_t length, uint32_t timeout_millis) {
+        if (sim_mode::source == conf.simulator.mode) {
+            return read_source(source_counter, dest, length, std::addressof(counters.read));
+        }
+        return read_completed(pipe, dest, length, timeout_millis, std::addressof(counters.read));
+    }
+
+    // called under 'in_mutex', returns whatever arrives first
+    size_t read_some(char* dest, size_t length, uint32_t timeout_millis, operation_stats* stats) {
+        if (sim_mode::source == conf.simulator.mode) {
+            return read_source(source_counter, dest, length, stats);
+        }
+        size_t got = pipe.pop(dest, length, timeout_millis, sim_mode::echo == conf.simulator.mode);
+        if (got > 0) {
+            link.transfer("libusb_bulk_transfer", got, stats);
+        }
+        return got;
+    }
+
+    // called under stream 'in_mutex'
+    size_t read_stream(sim_stream& st, char* dest, size_t length, uint32_t timeout_millis,
+            operation_stats* stats) {
+        if (sim_mode::source == conf.simulator.mode) {
+            return read_source(st.source_counter, dest, length, stats);
+        }
+        return read_completed(st.pipe, dest, length, timeout_millis, stats);
+    }
+
+    // the same counter pattern is produced by all IN endpoints
+    size_t read_source(uint8_t& counter, char* dest, size_t length, operation_stats* stats) {
+        link.transfer("libusb_bulk_transfer", length, stats);
+        for (size_t i = 0; i < length; i++) {
+            dest[i] = static_cast<char>(counter++);
+        }
+        return length;
+    }
+
+    // follows 'read_sync' of the libusb backend, queued data that ends
+    // before the requested length is handled as a short packet
+    size_t read_completed(sim_pipe& from, char* dest, size_t length, uint32_t timeout_millis,
+            operation_stats* stats) {
+        if (0 == length) {
+            return 0;
+        }
+        auto& rc = conf.read_completion;
+        size_t min_length = rc.min_length_for(static_cast<uint32_t>(length));
+        bool single_transfer = sim_mode::echo == conf.simulator.mode;
+        uint64_t finish = sl::utils::current_time_millis_steady() + timeout_millis;
+        uint64_t cur = sl::utils::current_time_millis_steady();
+        size_t got = 0;
+        while (cur < finish) {
+            uint32_t tm = static_cast<uint32_t>(finish - cur);
+            // idle interval is counted between transfers, after the first byte
+            bool idle = got > 0 && rc.idle_timeout_millis > 0 && rc.idle_timeout_millis < tm;
+            if (idle) {
+                tm = rc.idle_timeout_millis;
+            }
+            size_t requested = length - got;
+            size_t read = from.pop(dest + got, requested, tm, single_transfer);
+            if (read > 0) {
+                link.transfer("libusb_bulk_transfer", read, stats);
+                got += read;
+                if (got >= min_length || (rc.short_packet && read < requested)) {
+                    break;
+                }
+            } else if (idle) {
+                break;
+            }
+            cur = sl::utils::current_time_millis_steady();
+        }
+        return got;
+    }
+
+    // called under 'out_mutex'
+    size_t write_device(const char* data, size_t len) {
+        link.transfer("libusb_bulk_transfer", len, std::addressof(counters.write));
+        if (sim_mode::source != conf.simulator.mode) {
+            pipe.push(data, len);
+        }
+        return len;
+    }
+};
+PIMPL_FORWARD_CONSTRUCTOR(connection, (usb_config&&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read, (uint32_t), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, read_into, (sl::io::span<char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_frame, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_frame, (const frame_spec&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_endpoint, (const std::string&)(uint32_t), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, write, (sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, write_endpoint, (const std::string&)(sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, writev, (const std::vector<sl::io::span<const char>>&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::vector<std::string>, transact, (const std::vector<sl::io::span<const char>>&)(const transaction_options&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, control, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, control_request, prepare_control, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, execute_control, (const control_request&)(const control_overrides&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::shared_ptr<transfer_future>, read_async, (uint32_t), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::shared_ptr<transfer_future>, write_async, (sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, write_file, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, write_file_stats, (), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, void, capture_start, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, capture_stop, (), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, stats, (bool), (), support::exception)
+PIMPL_FORWARD_METHOD_STATIC(connection, std::vector<sl::json::value>, list, (const usb_config&), (), support::exception)
+PIMPL_FORWARD_METHOD_STATIC(connection, void, initialize, (), (), support::exception)
+
+} // namespace
+}
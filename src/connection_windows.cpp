@@ -23,8 +23,10 @@
 
 #include "connection.hpp"
 
+#include <array>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <tuple>
 #include <vector>
@@ -46,6 +48,10 @@ extern "C" {
 #include "wilton/support/exception.hpp"
 #include "wilton/support/misc.hpp"
 
+#include "frame_reader.hpp"
+#include "transact_loop.hpp"
+#include "transfer_stats.hpp"
+
 namespace wilton {
 namespace usb {
 
@@ -54,12 +60,28 @@ class connection::impl : public staticlib::pimpl::object::impl {
 
     HANDLE handle = nullptr;
     HIDP_CAPS caps;
-    
+
+    // reads and writes are serialized per direction only,
+    // overlapped IO allows them to run concurrently
+    std::mutex in_mutex;
+    std::mutex out_mutex;
+    std::mutex control_mutex;
+
+    // guarded by 'in_mutex'
+    frame_reader frames;
+
+    transfer_stats counters;
 
 public:
     impl(usb_config&& conf) :
     conf(std::move(conf)) {
-        this->handle = find_and_open_by_vid_pid(this->conf.vendor_id, this->conf.product_id);
+        if (-1 != this->conf.bus_number || !this->conf.port_path.empty()) throw support::exception(TRACEMSG(
+                "Selecting device by 'busNumber' or 'portPath' is not supported on Windows"));
+        if (!this->conf.endpoint_sets.empty()) throw support::exception(TRACEMSG(
+                "Endpoint sets are not supported on Windows"));
+        if (this->conf.simulated) throw support::exception(TRACEMSG(
+                "Parameter 'simulator' requires the module built with 'WILTON_USB_BACKEND=sim'"));
+        this->handle = find_and_open_by_vid_pid(this->conf.vendor_id, this->conf.product_id, this->conf.serial_number);
         std::memset(std::addressof(this->caps), '\0', sizeof(this->caps));
         get_device_capabilities(this->handle, this->caps, this->conf.vendor_id, this->conf.product_id);
     }
@@ -70,12 +92,85 @@ public:
         }
     }
 
-    std::string read(connection&, uint32_t length_ret) {
+    std::string read(connection&, uint32_t length) {
+        std::lock_guard<std::mutex> guard{in_mutex};
+        stats_scope scope(counters.read);
+        auto res = std::string();
+        if (!frames.empty()) {
+            res.resize(length);
+            res.resize(frames.take(std::addressof(res.front()), length));
+            if (res.length() == length) {
+                scope.done(length, res.length());
+                return res;
+            }
+        }
+        uint32_t remaining = length - static_cast<uint32_t>(res.length());
+        res.append(read_locked(remaining, conf.read_completion.min_length_for(remaining), conf.timeout_millis));
+        scope.done(length, res.length());
+        return res;
+    }
+
+    // HID reports carry the report ID byte, so data is read through the intermediate string
+    uint32_t read_into(connection& frontend, sl::io::span<char> dest) {
+        auto res = read(frontend, static_cast<uint32_t>(dest.size()));
+        if (!res.empty()) {
+            std::memcpy(dest.data(), res.data(), res.length());
+        }
+        return static_cast<uint32_t>(res.length());
+    }
+
+    std::string read_frame(connection& frontend, const sl::json::value& framing) {
+        auto spec = frame_spec(framing);
+        return read_frame(frontend, spec);
+    }
+
+    std::string read_frame(connection&, const frame_spec& spec) {
+        std::lock_guard<std::mutex> guard{in_mutex};
+        stats_scope scope(counters.read);
+        return scope.done_message(frames.read_frame(spec, conf.timeout_millis, conf.buffer_size,
+                [this](char* dest, size_t chunk, uint32_t timeout_millis) -> size_t {
+            auto res = this->read_locked(static_cast<uint32_t>(chunk), 1, timeout_millis);
+            if (!res.empty()) {
+                std::memcpy(dest, res.data(), res.length());
+            }
+            return res.length();
+        }));
+    }
+
+private:
+    // called under 'in_mutex', empty result means timeout
+    std::string read_response(const transaction_options& options, uint32_t timeout_millis) {
+        if (options.framed) {
+            return frames.read_frame(options.framing, timeout_millis, conf.buffer_size,
+                    [this](char* dest, size_t chunk, uint32_t remaining_millis) -> size_t {
+                auto res = this->read_locked(static_cast<uint32_t>(chunk), 1, remaining_millis);
+                if (!res.empty()) {
+                    std::memcpy(dest, res.data(), res.length());
+                }
+                return res.length();
+            });
+        }
+        uint32_t length = options.response_length;
+        auto res = std::string();
+        if (!frames.empty()) {
+            res.resize(length);
+            res.resize(frames.take(std::addressof(res.front()), length));
+        }
+        if (res.length() < length) {
+            uint32_t remaining = length - static_cast<uint32_t>(res.length());
+            res.append(read_locked(remaining, conf.read_completion.min_length_for(remaining), timeout_millis));
+        }
+        return res;
+    }
+
+    // returns as soon as 'min_length_ret' bytes are read
+    std::string read_locked(uint32_t length_ret, uint32_t min_length_ret, uint32_t timeout_millis) {
         uint64_t start = sl::utils::current_time_millis_steady();
-        uint64_t finish = start + conf.timeout_millis;
+        uint64_t finish = start + timeout_millis;
         uint64_t cur = start;
         std::string res;
         uint32_t length = length_ret + 1;
+        uint32_t min_length = min_length_ret + 1;
         for (;;) {
             // (err, bytes_read, flag)
             bool completion_called_flag = false;
@@ -95,8 +190,14 @@ public:
 
             // prepare read
             uint32_t passed = static_cast<uint32_t> (cur - start);
-            int rtm = static_cast<int> (conf.timeout_millis - passed);
+            int rtm = static_cast<int> (timeout_millis - passed);
             auto prev_len = res.length();
+            // idle interval is counted between reports, after the first one
+            uint32_t idle_millis = conf.read_completion.idle_timeout_millis;
+            bool idle = prev_len > 0 && idle_millis > 0 && static_cast<int>(idle_millis) < rtm;
+            if (idle) {
+                rtm = static_cast<int> (idle_millis);
+            }
             res.resize(length);
             auto rlen = length - prev_len;
 
@@ -156,11 +257,18 @@ public:
 
                 auto read = static_cast<size_t>(read_checked > std::get<1>(state) ? read_checked : std::get<1>(state));
                 res.resize(prev_len + read);
-                if (res.length() >= length) {
+                if (res.length() >= length || res.length() >= min_length) {
+                    break;
+                }
+                // HID report, that is shorter than requested, ends the transfer
+                if (conf.read_completion.short_packet && read < rlen) {
                     break;
                 }
             } else if (ERROR_OPERATION_ABORTED == std::get<0>(state)) {
                 res.resize(prev_len);
+                if (idle) {
+                    break;
+                }
             } else throw support::exception(TRACEMSG(
                     "USB 'FileIOCompletionRoutine' error, VID: [" + sl::support::to_string(this->conf.vendor_id) + "]," +
                     " PID: [" + sl::support::to_string(this->conf.product_id) + "]" +
@@ -177,7 +285,23 @@ public:
         return res.length() > 0 ? res.substr(1) : std::string();
     }
 
+public:
+    std::string read_endpoint(connection&, const std::string&, uint32_t) {
+        throw support::exception(TRACEMSG("Endpoint sets are not supported on Windows"));
+    }
+
+    uint32_t write_endpoint(connection&, const std::string&, sl::io::span<const char>) {
+        throw support::exception(TRACEMSG("Endpoint sets are not supported on Windows"));
+    }
+
     uint32_t write(connection&, sl::io::span<const char> data_req) {
+        std::lock_guard<std::mutex> guard{out_mutex};
+        stats_scope scope(counters.write);
+        return scope.done(data_req.size(), write_locked(data_req));
+    }
+
+    // called under 'out_mutex'
+    uint32_t write_locked(sl::io::span<const char> data_req) {
         auto data_str = std::string();
         data_str.resize(data_req.size() + 1);
         std::memcpy(std::addressof(data_str.front()) + 1, data_req.data(), data_req.size());
@@ -282,48 +406,138 @@ public:
             }
         }
         return static_cast<uint32_t>(written);
-        
     }
 
-    std::string control(connection&, const sl::json::value& control_options) {
-        // parse options
-        auto rdata = std::ref(sl::utils::empty_string());
-        auto rdatahex = std::ref(sl::utils::empty_string());
-        for (const sl::json::field& fi : control_options.as_object()) {
-            auto& name = fi.name();
-            if ("data" == name) {
-                rdata = fi.as_string_nonempty_or_throw(name);
-            } else if ("dataHex" == name) {
-                rdatahex = fi.as_string_nonempty_or_throw(name);
-            }
+    // HID output report is sent with a single 'WriteFileEx' call and
+    // needs to be prefixed with a report ID, so segments are joined here
+    uint32_t writev(connection& frontend, const std::vector<sl::io::span<const char>>& segments) {
+        auto joined = std::string();
+        for (auto& seg : segments) {
+            joined.append(seg.data(), seg.size());
         }
-        if (rdata.get().length() > conf.buffer_size) throw support::exception(TRACEMSG(
-                "Invalid parameter 'data', size: [" + sl::support::to_string(rdata.get().size()) + "]"));
-        if (rdatahex.get().length() > conf.buffer_size) throw support::exception(TRACEMSG(
-                "Invalid parameter 'dataHex', size: [" + sl::support::to_string(rdatahex.get().size()) + "]"));
-        std::string data = !rdata.get().empty() ? rdata.get() : sl::io::string_from_hex(rdatahex.get());
+        return write(frontend, sl::io::make_span(joined.data(), joined.size()));
+    }
+
+    // HID writes are limited by the connection timeout, the overall
+    // deadline is checked between the reports
+    std::vector<std::string> transact(connection&, const std::vector<sl::io::span<const char>>& requests,
+            const transaction_options& options) {
+        std::lock(out_mutex, in_mutex);
+        std::lock_guard<std::mutex> out_guard{out_mutex, std::adopt_lock};
+        std::lock_guard<std::mutex> in_guard{in_mutex, std::adopt_lock};
+        return transact_loop(requests, options, conf.timeout_millis,
+                [this](const sl::io::span<const char>& req, uint64_t finish) -> bool {
+                    if (sl::utils::current_time_millis_steady() >= finish) {
+                        return false;
+                    }
+                    stats_scope scope(counters.write);
+                    return scope.done(req.size(), this->write_locked(req)) == req.size();
+                },
+                [this, &options](uint32_t timeout_millis) {
+                    stats_scope scope(counters.read);
+                    return scope.done_message(this->read_response(options, timeout_millis));
+                });
+    }
+
+    std::string control(connection& frontend, const sl::json::value& control_options) {
+        auto req = prepare_control(frontend, control_options);
+        return execute_control(frontend, req, control_overrides());
+    }
+
+    control_request prepare_control(connection&, const sl::json::value& control_options) {
+        auto req = control_request(control_options);
+        check_control(req, sl::io::make_span(req.data.data(), req.data.length()));
+        return req;
+    }
+
+    // request fields are not used with HID, only the report size is checked
+    void check_control(const control_request&, sl::io::span<const char> data) {
+        if (data.size() > conf.buffer_size) throw support::exception(TRACEMSG(
+                "Invalid parameter 'data', size: [" + sl::support::to_string(data.size()) + "]," +
+                " max size: [" + sl::support::to_string(conf.buffer_size) + "]"));
+    }
+
+    // only feature report data is used, other control fields are ignored with HID
+    std::string execute_control(connection&, const control_request& req, const control_overrides& overrides) {
+        auto data = overrides.data_or(req.data);
+        check_control(req, data);
         auto data_pass = std::string();
-        data_pass.resize(data.length() + 1);
+        data_pass.resize(data.size() + 1);
         data_pass[0] = '\0';
-        std::memcpy(std::addressof(data_pass.front()) + 1, data.c_str(), data.length());
+        if (data.size() > 0) {
+            std::memcpy(std::addressof(data_pass.front()) + 1, data.data(), data.size());
+        }
+        std::lock_guard<std::mutex> guard{control_mutex};
+        stats_scope scope(counters.control);
         auto err = ::HidD_SetFeature(
                 this->handle,
                 reinterpret_cast<void*>(std::addressof(data_pass.front())),
                 this->caps.FeatureReportByteLength);
-        if (0 == err) throw support::exception(TRACEMSG(
-                "USB 'HidD_SetFeature' error, VID: [" + sl::support::to_string(this->conf.vendor_id) + "]," +
-                " PID: [" + sl::support::to_string(this->conf.product_id) + "]" +
-                " data: [" + sl::io::format_plain_as_hex(data) + "]" +
-                " error: [" + sl::utils::errcode_to_string(::GetLastError()) + "]"));
-        return data;
+        if (0 == err) {
+            auto errcode = ::GetLastError();
+            counters.control.record_error_code(static_cast<int64_t>(errcode));
+            throw support::exception(TRACEMSG(
+                    "USB 'HidD_SetFeature' error, VID: [" + sl::support::to_string(this->conf.vendor_id) + "]," +
+                    " PID: [" + sl::support::to_string(this->conf.product_id) + "]" +
+                    " data: [" + sl::io::format_plain_as_hex(std::string(data.data(), data.size())) + "]" +
+                    " error: [" + sl::utils::errcode_to_string(errcode) + "]"));
+        }
+        scope.done(data.size(), data.size());
+        return std::string(data.data(), data.size());
+    }
+
+    // HID reports are small, operations are performed synchronously
+    // and the future is returned already completed
+    std::shared_ptr<transfer_future> read_async(connection& frontend, uint32_t length) {
+        auto res = std::make_shared<transfer_future>(transfer_future::kind::read);
+        try {
+            res->complete_read(read(frontend, length));
+        } catch (const std::exception& e) {
+            res->fail(e.what());
+        }
+        return res;
+    }
+
+    std::shared_ptr<transfer_future> write_async(connection& frontend, sl::io::span<const char> data) {
+        auto res = std::make_shared<transfer_future>(transfer_future::kind::write);
+        try {
+            res->complete_write(write(frontend, data));
+        } catch (const std::exception& e) {
+            res->fail(e.what());
+        }
+        return res;
+    }
+
+    sl::json::value write_file(connection&, const sl::json::value&) {
+        throw support::exception(TRACEMSG("File write is not supported on Windows"));
+    }
+
+    sl::json::value write_file_stats(connection&) {
+        throw support::exception(TRACEMSG("File write is not supported on Windows"));
+    }
+
+    void capture_start(connection&, const sl::json::value&) {
+        throw support::exception(TRACEMSG("Capture is not supported on Windows"));
+    }
+
+    sl::json::value capture_stop(connection&) {
+        throw support::exception(TRACEMSG("Capture is not supported on Windows"));
+    }
+
+    sl::json::value stats(connection&, bool reset) {
+        return counters.to_json(reset);
     }
 
     static void initialize() {
         // no-op
     }
 
+    static std::vector<sl::json::value> list(const usb_config&) {
+        throw support::exception(TRACEMSG("Listing devices is not supported on Windows"));
+    }
+
 private:
-    static HANDLE find_and_open_by_vid_pid(uint16_t vid, uint16_t pid) {
+    static HANDLE find_and_open_by_vid_pid(uint16_t vid, uint16_t pid, const std::string& serial) {
         GUID hid_guid;
         std::memset(std::addressof(hid_guid), '\0', sizeof(hid_guid));
         ::HidD_GetHidGuid(std::addressof(hid_guid));
@@ -433,7 +647,8 @@ private:
                     " index: [" + sl::support::to_string(dev_idx) + "]" +
                     " error: [" + sl::utils::errcode_to_string(::GetLastError()) + "]"));
 
-            if (attributes.VendorID == vid && attributes.ProductID == pid) {
+            if (attributes.VendorID == vid && attributes.ProductID == pid &&
+                    (serial.empty() || serial == read_serial(handle))) {
                 return handle;
             } else {
                 vid_pid_list.emplace_back(attributes.VendorID, attributes.ProductID);
@@ -448,6 +663,18 @@ private:
                 " found devices [" + print_vid_pid_list(vid_pid_list) + "]")); 
     }
 
+    // empty string if device has no serial number
+    static std::string read_serial(HANDLE handle) {
+        std::array<wchar_t, 256> buf;
+        std::memset(buf.data(), '\0', buf.size() * sizeof(wchar_t));
+        auto err = ::HidD_GetSerialNumberString(handle, buf.data(), static_cast<ULONG>(buf.size() * sizeof(wchar_t)));
+        if (0 == err) {
+            return std::string();
+        }
+        buf.back() = L'\0';
+        return sl::utils::narrow(buf.data());
+    }
+
     static void get_device_capabilities(HANDLE handle, HIDP_CAPS& caps, uint16_t vid, uint16_t pid) {
         PHIDP_PREPARSED_DATA ppd = nullptr;
         
@@ -491,8 +718,25 @@ private:
 };
 PIMPL_FORWARD_CONSTRUCTOR(connection, (usb_config&&), (), support::exception)
 PIMPL_FORWARD_METHOD(connection, std::string, read, (uint32_t), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, read_into, (sl::io::span<char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_frame, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_frame, (const frame_spec&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, read_endpoint, (const std::string&)(uint32_t), (), support::exception)
 PIMPL_FORWARD_METHOD(connection, uint32_t, write, (sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, write_endpoint, (const std::string&)(sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, uint32_t, writev, (const std::vector<sl::io::span<const char>>&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::vector<std::string>, transact, (const std::vector<sl::io::span<const char>>&)(const transaction_options&), (), support::exception)
 PIMPL_FORWARD_METHOD(connection, std::string, control, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, control_request, prepare_control, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::string, execute_control, (const control_request&)(const control_overrides&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::shared_ptr<transfer_future>, read_async, (uint32_t), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, std::shared_ptr<transfer_future>, write_async, (sl::io::span<const char>), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, write_file, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, write_file_stats, (), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, void, capture_start, (const sl::json::value&), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, capture_stop, (), (), support::exception)
+PIMPL_FORWARD_METHOD(connection, sl::json::value, stats, (bool), (), support::exception)
+PIMPL_FORWARD_METHOD_STATIC(connection, std::vector<sl::json::value>, list, (const usb_config&), (), support::exception)
 PIMPL_FORWARD_METHOD_STATIC(connection, void, initialize, (), (), support::exception)
 
 } // namespace
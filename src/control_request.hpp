@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   control_request.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:18 AM
+ */
+
+#ifndef WILTON_USB_CONTROL_REQUEST_HPP
+#define WILTON_USB_CONTROL_REQUEST_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Parsed control transfer options, data is stored already decoded;
+ * when data is not specified, IN transfer of 'bufferSize' is performed,
+ * when data is 'null', transfer without data stage is performed
+ */
+class control_request {
+public:
+    uint8_t request_type = 0;
+    uint8_t request = 0;
+    uint16_t value = 0;
+    uint16_t index = 0;
+    bool data_specified = true;
+    std::string data;
+    bool reset = false;
+
+    control_request(const control_request&) = delete;
+
+    control_request& operator=(const control_request&) = delete;
+
+    control_request(control_request&& other) :
+    request_type(other.request_type),
+    request(other.request),
+    value(other.value),
+    index(other.index),
+    data_specified(other.data_specified),
+    data(std::move(other.data)),
+    reset(other.reset) { }
+
+    control_request& operator=(control_request&& other) {
+        request_type = other.request_type;
+        request = other.request;
+        value = other.value;
+        index = other.index;
+        data_specified = other.data_specified;
+        data = std::move(other.data);
+        reset = other.reset;
+        return *this;
+    }
+
+    control_request() { }
+
+    control_request(const sl::json::value& json) {
+        bool data_found = false;
+        bool data_hex_found = false;
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("requestType" == name) {
+                this->request_type = as_uint8(fi);
+            } else if ("request" == name) {
+                this->request = as_uint8(fi);
+            } else if ("value" == name) {
+                this->value = fi.as_uint16_or_throw(name);
+            } else if ("index" == name) {
+                this->index = fi.as_uint16_or_throw(name);
+            } else if ("data" == name) {
+                data_found = true;
+                if (sl::json::type::nullt == fi.json_type()) {
+                    this->data_specified = false;
+                } else {
+                    this->data = fi.as_string_nonempty_or_throw(name);
+                }
+            } else if ("dataHex" == name) {
+                data_hex_found = true;
+                this->data = sl::io::string_from_hex(fi.as_string_nonempty_or_throw(name));
+            } else if ("reset" == name) {
+                this->reset = fi.as_bool_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+            }
+        }
+        if (data_found && data_hex_found) throw support::exception(TRACEMSG(
+                "Parameters 'data' and 'dataHex' cannot be specified together"));
+    }
+
+private:
+    static uint8_t as_uint8(const sl::json::field& fi) {
+        uint16_t val = fi.as_uint16_positive_or_throw(fi.name());
+        if (val > 0xff) throw support::exception(TRACEMSG(
+                "Invalid '" + fi.name() + "' field: [" + sl::support::to_string(val) + "]"));
+        return static_cast<uint8_t>(val);
+    }
+};
+
+/**
+ * Per-call changes applied to the prepared control request,
+ * negative 'value' or 'index' and null 'data' keep the prepared ones
+ */
+class control_overrides {
+public:
+    int32_t value = -1;
+    int32_t index = -1;
+    const char* data = nullptr;
+    size_t data_len = 0;
+
+    control_overrides() { }
+
+    control_overrides(int32_t value, int32_t index, const char* data, size_t data_len) :
+    value(value),
+    index(index),
+    data(data),
+    data_len(data_len) { }
+
+    uint16_t value_or(uint16_t prepared) const {
+        return value >= 0 ? static_cast<uint16_t>(value) : prepared;
+    }
+
+    uint16_t index_or(uint16_t prepared) const {
+        return index >= 0 ? static_cast<uint16_t>(index) : prepared;
+    }
+
+    sl::io::span<const char> data_or(const std::string& prepared) const {
+        if (nullptr != data) {
+            return sl::io::make_span(data, data_len);
+        }
+        return sl::io::make_span(prepared.data(), prepared.length());
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_CONTROL_REQUEST_HPP */
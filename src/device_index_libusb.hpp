@@ -0,0 +1,270 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   device_index_libusb.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:06 AM
+ */
+
+#ifndef WILTON_USB_DEVICE_INDEX_LIBUSB_HPP
+#define WILTON_USB_DEVICE_INDEX_LIBUSB_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "libusb-1.0/libusb.h"
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Process-wide index of attached devices keyed by VID/PID, that is
+ * maintained from hotplug notifications, so opening a device does not
+ * need to enumerate the bus and to read descriptors of all devices on it;
+ * falls back to bus enumeration on each lookup on platforms without
+ * hotplug support
+ */
+class device_index_libusb {
+public:
+    struct device_deleter {
+        void operator()(libusb_device* dev) {
+            libusb_unref_device(dev);
+        }
+    };
+
+    using device_ptr = std::unique_ptr<libusb_device, device_deleter>;
+
+private:
+    libusb_context* ctx;
+    std::mutex mutex;
+    std::condition_variable cv;
+    // referenced devices in arrival order
+    std::unordered_map<uint32_t, std::vector<libusb_device*>> devices;
+    uint64_t arrivals = 0;
+    bool hotplug = false;
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+    libusb_hotplug_callback_handle callback_handle;
+#endif // LIBUSB_API_VERSION
+
+public:
+    explicit device_index_libusb(libusb_context* ctx) :
+    ctx(ctx) {
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+        if (0 != libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+            // already attached devices are reported from within this call
+            auto err = libusb_hotplug_register_callback(ctx,
+                    static_cast<libusb_hotplug_event>(LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+                    LIBUSB_HOTPLUG_ENUMERATE, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+                    LIBUSB_HOTPLUG_MATCH_ANY, device_index_libusb::on_hotplug, static_cast<void*>(this),
+                    std::addressof(callback_handle));
+            if (LIBUSB_SUCCESS != err) {
+                clear();
+                throw support::exception(TRACEMSG(
+                        "USB 'libusb_hotplug_register_callback' error, code: [" + sl::support::to_string(err) + "]"));
+            }
+            this->hotplug = true;
+        }
+#endif // LIBUSB_API_VERSION
+    }
+
+    device_index_libusb(const device_index_libusb&) = delete;
+
+    device_index_libusb& operator=(const device_index_libusb&) = delete;
+
+    ~device_index_libusb() STATICLIB_NOEXCEPT {
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+        if (hotplug) {
+            libusb_hotplug_deregister_callback(ctx, callback_handle);
+        }
+#endif // LIBUSB_API_VERSION
+        clear();
+    }
+
+    /**
+     * Returns all attached devices with the specified VID/PID in arrival order
+     */
+    std::vector<device_ptr> find_all(uint16_t vid, uint16_t pid) {
+        auto res = std::vector<device_ptr>();
+        if (!hotplug) {
+            enumerate([vid, pid, &res](libusb_device* dev, const libusb_device_descriptor& desc) {
+                if (desc.idVendor == vid && desc.idProduct == pid) {
+                    res.emplace_back(libusb_ref_device(dev));
+                }
+            });
+            return res;
+        }
+        std::lock_guard<std::mutex> guard{mutex};
+        auto it = devices.find(make_key(vid, pid));
+        if (devices.end() != it) {
+            for (libusb_device* dev : it->second) {
+                res.emplace_back(libusb_ref_device(dev));
+            }
+        }
+        return res;
+    }
+
+    /**
+     * Counter of device arrivals, used with 'wait_arrival'
+     */
+    uint64_t generation() {
+        std::lock_guard<std::mutex> guard{mutex};
+        return arrivals;
+    }
+
+    /**
+     * Waits until any device arrives after the specified generation,
+     * without hotplug support just sleeps for a short while
+     */
+    void wait_arrival(uint64_t since_generation, uint32_t timeout_millis) {
+        if (!hotplug) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<uint32_t>(100, timeout_millis)));
+            return;
+        }
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait_for(lock, std::chrono::milliseconds(timeout_millis), [this, since_generation] {
+            return arrivals != since_generation;
+        });
+    }
+
+    /**
+     * Checks whether the specified device is still attached
+     */
+    bool contains(libusb_device* dev) {
+        if (!hotplug) {
+            bool found = false;
+            enumerate([dev, &found](libusb_device* el, const libusb_device_descriptor&) {
+                found = found || el == dev;
+            });
+            return found;
+        }
+        std::lock_guard<std::mutex> guard{mutex};
+        for (auto& en : devices) {
+            for (libusb_device* el : en.second) {
+                if (el == dev) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * VID/PID pairs of all attached devices, used for error reporting
+     */
+    std::vector<std::pair<uint16_t, uint16_t>> list() {
+        auto res = std::vector<std::pair<uint16_t, uint16_t>>();
+        if (!hotplug) {
+            enumerate([&res](libusb_device*, const libusb_device_descriptor& desc) {
+                res.emplace_back(desc.idVendor, desc.idProduct);
+            });
+            return res;
+        }
+        std::lock_guard<std::mutex> guard{mutex};
+        for (auto& en : devices) {
+            for (size_t i = 0; i < en.second.size(); i++) {
+                res.emplace_back(static_cast<uint16_t>(en.first >> 16), static_cast<uint16_t>(en.first & 0xffff));
+            }
+        }
+        return res;
+    }
+
+private:
+    static uint32_t make_key(uint16_t vid, uint16_t pid) {
+        return (static_cast<uint32_t>(vid) << 16) | pid;
+    }
+
+    template<typename Visitor>
+    void enumerate(Visitor visitor) {
+        struct libusb_device **devlist = nullptr;
+        auto err_getlist = libusb_get_device_list(ctx, std::addressof(devlist));
+        if (err_getlist < 0) {
+            throw support::exception(TRACEMSG(
+                    "USB 'libusb_get_device_list' error, code: [" + sl::support::to_string(err_getlist) + "]"));
+        }
+        auto deferred = sl::support::defer([devlist] () STATICLIB_NOEXCEPT {
+            libusb_free_device_list(devlist, 1);
+        });
+        size_t devlist_size = static_cast<size_t>(err_getlist);
+        for (size_t i = 0; i < devlist_size; i++) {
+            struct libusb_device_descriptor desc;
+            auto err_desc = libusb_get_device_descriptor(devlist[i], std::addressof(desc));
+            if (LIBUSB_SUCCESS != err_desc) {
+                throw support::exception(TRACEMSG(
+                        "USB 'libusb_get_device_descriptor' error, code: [" + sl::support::to_string(err_desc) + "]"));
+            }
+            visitor(devlist[i], desc);
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard{mutex};
+        for (auto& en : devices) {
+            for (libusb_device* dev : en.second) {
+                libusb_unref_device(dev);
+            }
+        }
+        devices.clear();
+    }
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+    // called from the context event thread, device descriptor is cached by libusb
+    static int LIBUSB_CALL on_hotplug(libusb_context*, libusb_device* dev, libusb_hotplug_event event,
+            void* user_data) {
+        auto self = static_cast<device_index_libusb*>(user_data);
+        struct libusb_device_descriptor desc;
+        if (LIBUSB_SUCCESS != libusb_get_device_descriptor(dev, std::addressof(desc))) {
+            return 0;
+        }
+        std::lock_guard<std::mutex> guard{self->mutex};
+        auto& list = self->devices[make_key(desc.idVendor, desc.idProduct)];
+        if (LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED == event) {
+            list.push_back(libusb_ref_device(dev));
+            self->arrivals += 1;
+            self->cv.notify_all();
+        } else {
+            for (auto it = list.begin(); it != list.end(); ++it) {
+                if (*it == dev) {
+                    libusb_unref_device(dev);
+                    list.erase(it);
+                    break;
+                }
+            }
+        }
+        // stay registered
+        return 0;
+    }
+#endif // LIBUSB_API_VERSION
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_DEVICE_INDEX_LIBUSB_HPP */
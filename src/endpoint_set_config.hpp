@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   endpoint_set_config.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:24 AM
+ */
+
+#ifndef WILTON_USB_ENDPOINT_SET_CONFIG_HPP
+#define WILTON_USB_ENDPOINT_SET_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "transfer_type.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Additional named pair of endpoints on the same device, for example
+ * on another interface; at least one of the endpoints must be specified
+ */
+class endpoint_set_config {
+public:
+    uint32_t out_endpoint = 0;
+    uint32_t in_endpoint = 0;
+    transfer_type in_transfer_type = transfer_type::bulk;
+    transfer_type out_transfer_type = transfer_type::bulk;
+
+    endpoint_set_config(const endpoint_set_config&) = delete;
+
+    endpoint_set_config& operator=(const endpoint_set_config&) = delete;
+
+    endpoint_set_config(endpoint_set_config&& other) :
+    out_endpoint(other.out_endpoint),
+    in_endpoint(other.in_endpoint),
+    in_transfer_type(other.in_transfer_type),
+    out_transfer_type(other.out_transfer_type) { }
+
+    endpoint_set_config& operator=(endpoint_set_config&& other) {
+        out_endpoint = other.out_endpoint;
+        in_endpoint = other.in_endpoint;
+        in_transfer_type = other.in_transfer_type;
+        out_transfer_type = other.out_transfer_type;
+        return *this;
+    }
+
+    endpoint_set_config() { }
+
+    endpoint_set_config(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object_or_throw("endpointSets")) {
+            auto& name = fi.name();
+            if ("outEndpoint" == name) {
+                this->out_endpoint = fi.as_uint32_positive_or_throw(name);
+            } else if ("inEndpoint" == name) {
+                this->in_endpoint = fi.as_uint32_positive_or_throw(name);
+            } else if ("inTransferType" == name) {
+                this->in_transfer_type = parse_transfer_type(fi);
+            } else if ("outTransferType" == name) {
+                this->out_transfer_type = parse_transfer_type(fi);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'endpointSets' entry field: [" + name + "]"));
+            }
+        }
+        if (0 == out_endpoint && 0 == in_endpoint) throw support::exception(TRACEMSG(
+                "Invalid 'endpointSets' entry, 'inEndpoint' or 'outEndpoint' must be specified"));
+        // streaming modes are only supported for the main endpoints
+        if (transfer_type::isochronous == in_transfer_type || transfer_type::isochronous == out_transfer_type) {
+            throw support::exception(TRACEMSG(
+                    "Invalid 'endpointSets' entry, 'isochronous' transfer type is not supported"));
+        }
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "outEndpoint", out_endpoint },
+            { "inEndpoint", in_endpoint },
+            { "inTransferType", stringify_transfer_type(in_transfer_type) },
+            { "outTransferType", stringify_transfer_type(out_transfer_type) }
+        };
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_ENDPOINT_SET_CONFIG_HPP */
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   file_write_options.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:29 AM
+ */
+
+#ifndef WILTON_USB_FILE_WRITE_OPTIONS_HPP
+#define WILTON_USB_FILE_WRITE_OPTIONS_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * File is sent to the OUT endpoint in 'chunkSize' transfers (rounded down
+ * to the max packet size), up to 'transfers' of them are in flight;
+ * with 'zeroLengthPacket' the file, that ends on the packet boundary,
+ * is terminated with ZLP
+ */
+class file_write_options {
+public:
+    std::string path;
+    uint32_t chunk_size = 65536;
+    uint32_t transfers = 4;
+    bool zero_length_packet = true;
+    // per transfer, zero means connection 'timeoutMillis'
+    uint32_t timeout_millis = 0;
+
+    file_write_options(const file_write_options&) = delete;
+
+    file_write_options& operator=(const file_write_options&) = delete;
+
+    file_write_options(file_write_options&& other) :
+    path(std::move(other.path)),
+    chunk_size(other.chunk_size),
+    transfers(other.transfers),
+    zero_length_packet(other.zero_length_packet),
+    timeout_millis(other.timeout_millis) { }
+
+    file_write_options& operator=(file_write_options&& other) {
+        path = std::move(other.path);
+        chunk_size = other.chunk_size;
+        transfers = other.transfers;
+        zero_length_packet = other.zero_length_packet;
+        timeout_millis = other.timeout_millis;
+        return *this;
+    }
+
+    file_write_options() { }
+
+    file_write_options(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("path" == name) {
+                this->path = fi.as_string_nonempty_or_throw(name);
+            } else if ("chunkSize" == name) {
+                this->chunk_size = fi.as_uint32_positive_or_throw(name);
+            } else if ("transfers" == name) {
+                this->transfers = fi.as_uint32_positive_or_throw(name);
+            } else if ("zeroLengthPacket" == name) {
+                this->zero_length_packet = fi.as_bool_or_throw(name);
+            } else if ("timeoutMillis" == name) {
+                this->timeout_millis = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'writeFile' field: [" + name + "]"));
+            }
+        }
+        if (path.empty()) throw support::exception(TRACEMSG(
+                "Required parameter 'path' not specified"));
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_FILE_WRITE_OPTIONS_HPP */
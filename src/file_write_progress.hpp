@@ -0,0 +1,120 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   file_write_progress.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:29 AM
+ */
+
+#ifndef WILTON_USB_FILE_WRITE_PROGRESS_HPP
+#define WILTON_USB_FILE_WRITE_PROGRESS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/utils.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * State of the current (or the last finished) file write, updated
+ * from the transfer callbacks and read from other threads
+ */
+class file_write_progress {
+    std::mutex path_mutex;
+    std::string path;
+    std::atomic<uint64_t> bytes_total;
+    std::atomic<uint64_t> bytes_written;
+    std::atomic<uint32_t> in_flight;
+    std::atomic<uint64_t> started_millis;
+    std::atomic<uint64_t> finished_millis;
+    std::atomic<bool> running;
+
+public:
+    file_write_progress() :
+    bytes_total(0),
+    bytes_written(0),
+    in_flight(0),
+    started_millis(0),
+    finished_millis(0),
+    running(false) { }
+
+    file_write_progress(const file_write_progress&) = delete;
+
+    file_write_progress& operator=(const file_write_progress&) = delete;
+
+    void begin(const std::string& file_path, uint64_t total) {
+        {
+            std::lock_guard<std::mutex> guard{path_mutex};
+            path = file_path;
+        }
+        bytes_total.store(total);
+        bytes_written.store(0);
+        in_flight.store(0);
+        started_millis.store(sl::utils::current_time_millis_steady());
+        finished_millis.store(0);
+        running.store(true);
+    }
+
+    void add_written(uint64_t count) {
+        bytes_written.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void set_in_flight(uint32_t count) {
+        in_flight.store(count, std::memory_order_relaxed);
+    }
+
+    void end() {
+        in_flight.store(0);
+        finished_millis.store(sl::utils::current_time_millis_steady());
+        running.store(false);
+    }
+
+    uint64_t written() const {
+        return bytes_written.load();
+    }
+
+    sl::json::value to_json() {
+        auto fpath = std::string();
+        {
+            std::lock_guard<std::mutex> guard{path_mutex};
+            fpath = path;
+        }
+        uint64_t started = started_millis.load();
+        uint64_t finished = finished_millis.load();
+        uint64_t until = 0 != finished ? finished : sl::utils::current_time_millis_steady();
+        return {
+            { "path", fpath },
+            { "running", running.load() },
+            { "bytesTotal", bytes_total.load() },
+            { "bytesWritten", bytes_written.load() },
+            { "transfersInFlight", in_flight.load() },
+            { "elapsedMillis", 0 != started ? until - started : 0 }
+        };
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_FILE_WRITE_PROGRESS_HPP */
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   frame_reader.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:13 AM
+ */
+
+#ifndef WILTON_USB_FRAME_READER_HPP
+#define WILTON_USB_FRAME_READER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/utils.hpp"
+
+#include "frame_spec.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Accumulates IN data until a complete frame is available, bytes
+ * received after the frame are kept for the next call; not thread-safe,
+ * used under the connection IN lock
+ */
+class frame_reader {
+    std::string pending;
+    size_t head = 0;
+    // delimiter search position relative to 'head', valid only for 'scan_delimiter'
+    size_t scan_from = 0;
+    std::string scan_delimiter;
+
+public:
+    frame_reader() { }
+
+    frame_reader(const frame_reader&) = delete;
+
+    frame_reader& operator=(const frame_reader&) = delete;
+
+    bool empty() const {
+        return head == pending.length();
+    }
+
+    /**
+     * Moves up to 'len' buffered bytes to 'dest', used by plain reads,
+     * so data after the last frame is not lost
+     */
+    size_t take(char* dest, size_t len) {
+        size_t avail = pending.length() - head;
+        size_t count = avail < len ? avail : len;
+        std::memcpy(dest, pending.data() + head, count);
+        consume(count);
+        return count;
+    }
+
+    /**
+     * Returns as soon as one frame is buffered, or empty string on timeout;
+     * 'read_some' receives destination, chunk size and the remaining time,
+     * and returns the number of bytes that arrived within it, chunks are
+     * read directly into the end of the pending buffer
+     */
+    template<typename ReadSome>
+    std::string read_frame(const frame_spec& spec, uint32_t timeout_millis, size_t chunk_size,
+            ReadSome read_some) {
+        uint64_t finish = sl::utils::current_time_millis_steady() + timeout_millis;
+        if (spec.delimiter != scan_delimiter) {
+            // position was found with another spec, search is restarted
+            scan_from = 0;
+            scan_delimiter = spec.delimiter;
+        }
+        for (;;) {
+            size_t frame_len = 0;
+            size_t consumed = 0;
+            bool found = false;
+            try {
+                found = spec.find(pending.data() + head, pending.length() - head, scan_from, frame_len, consumed);
+            } catch (...) {
+                // stream cannot be resynchronized, buffered data is dropped
+                clear();
+                throw;
+            }
+            if (found) {
+                auto res = pending.substr(head, frame_len);
+                consume(consumed);
+                return res;
+            }
+            uint64_t cur = sl::utils::current_time_millis_steady();
+            if (cur >= finish) {
+                return std::string();
+            }
+            size_t prev_len = pending.length();
+            pending.resize(prev_len + chunk_size);
+            size_t count = 0;
+            try {
+                count = read_some(std::addressof(pending.front()) + prev_len, chunk_size,
+                        static_cast<uint32_t>(finish - cur));
+            } catch (...) {
+                pending.resize(prev_len);
+                throw;
+            }
+            pending.resize(prev_len + count);
+        }
+    }
+
+    void clear() {
+        pending.clear();
+        head = 0;
+        scan_from = 0;
+    }
+
+private:
+    void consume(size_t count) {
+        head += count;
+        scan_from = 0;
+        if (head == pending.length()) {
+            pending.clear();
+            head = 0;
+        } else if (head > pending.length() / 2) {
+            // compact, so the buffer does not grow with the stream
+            pending.erase(0, head);
+            head = 0;
+        }
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_FRAME_READER_HPP */
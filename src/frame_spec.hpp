@@ -0,0 +1,229 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   frame_spec.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:13 AM
+ */
+
+#ifndef WILTON_USB_FRAME_SPEC_HPP
+#define WILTON_USB_FRAME_SPEC_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Describes how a message boundary is found in the IN stream:
+ * by delimiter bytes, by fixed length, or by length field
+ * at the fixed offset from the start of the frame
+ */
+class frame_spec {
+public:
+    enum class kind { delimiter, fixed, length_prefix };
+
+    kind type = kind::delimiter;
+    std::string delimiter;
+    bool include_delimiter = false;
+    uint32_t length = 0;
+    uint32_t offset = 0;
+    uint32_t width = 0;
+    bool big_endian = true;
+    // added to the length field value, negative when the field counts the header too
+    int32_t length_adjustment = 0;
+    uint32_t max_length = 65536;
+
+    frame_spec(const frame_spec&) = delete;
+
+    frame_spec& operator=(const frame_spec&) = delete;
+
+    frame_spec(frame_spec&& other) :
+    type(other.type),
+    delimiter(std::move(other.delimiter)),
+    include_delimiter(other.include_delimiter),
+    length(other.length),
+    offset(other.offset),
+    width(other.width),
+    big_endian(other.big_endian),
+    length_adjustment(other.length_adjustment),
+    max_length(other.max_length) { }
+
+    frame_spec& operator=(frame_spec&& other) {
+        type = other.type;
+        delimiter = std::move(other.delimiter);
+        include_delimiter = other.include_delimiter;
+        length = other.length;
+        offset = other.offset;
+        width = other.width;
+        big_endian = other.big_endian;
+        length_adjustment = other.length_adjustment;
+        max_length = other.max_length;
+        return *this;
+    }
+
+    frame_spec() { }
+
+    frame_spec(const sl::json::value& json) {
+        bool type_specified = false;
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("type" == name) {
+                this->type = parse_kind(fi);
+                type_specified = true;
+            } else if ("delimiter" == name) {
+                this->delimiter = fi.as_string_nonempty_or_throw(name);
+            } else if ("delimiterHex" == name) {
+                this->delimiter = sl::io::string_from_hex(fi.as_string_nonempty_or_throw(name));
+            } else if ("includeDelimiter" == name) {
+                this->include_delimiter = fi.as_bool_or_throw(name);
+            } else if ("length" == name) {
+                this->length = fi.as_uint32_positive_or_throw(name);
+            } else if ("offset" == name) {
+                this->offset = fi.as_uint32_or_throw(name);
+            } else if ("width" == name) {
+                this->width = fi.as_uint32_positive_or_throw(name);
+            } else if ("endianness" == name) {
+                this->big_endian = parse_endianness(fi);
+            } else if ("lengthAdjustment" == name) {
+                this->length_adjustment = fi.as_int32_or_throw(name);
+            } else if ("maxLength" == name) {
+                this->max_length = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'framing' field: [" + name + "]"));
+            }
+        }
+        if (!type_specified) throw support::exception(TRACEMSG(
+                "Required parameter 'framing.type' not specified"));
+        switch (type) {
+        case kind::delimiter:
+            if (delimiter.empty()) throw support::exception(TRACEMSG(
+                    "Required parameter 'framing.delimiter' not specified"));
+            break;
+        case kind::fixed:
+            if (0 == length) throw support::exception(TRACEMSG(
+                    "Required parameter 'framing.length' not specified"));
+            if (length > max_length) throw support::exception(TRACEMSG(
+                    "Invalid 'framing.length' field: [" + sl::support::to_string(length) + "]," +
+                    " max length: [" + sl::support::to_string(max_length) + "]"));
+            break;
+        case kind::length_prefix:
+            if (!(1 == width || 2 == width || 4 == width)) throw support::exception(TRACEMSG(
+                    "Invalid 'framing.width' field: [" + sl::support::to_string(width) + "]," +
+                    " supported values: [1, 2, 4]"));
+            break;
+        }
+    }
+
+    /**
+     * Returns 'true' if the complete frame is available at the start of the data,
+     * 'frame_len' receives frame length and 'consumed' receives number of bytes
+     * to drop from the input (differs from frame length for delimiters);
+     * 'scan_from' is the position, where delimiter search was stopped
+     * on the previous call with the same frame start
+     */
+    bool find(const char* data, size_t len, size_t& scan_from, size_t& frame_len, size_t& consumed) const {
+        switch (type) {
+        case kind::fixed:
+            frame_len = length;
+            consumed = length;
+            return len >= length;
+        case kind::length_prefix: {
+            size_t header_len = offset + width;
+            if (len < header_len) {
+                return false;
+            }
+            int64_t total = static_cast<int64_t>(header_len) + read_length_field(data + offset) + length_adjustment;
+            if (total < static_cast<int64_t>(header_len) || total > static_cast<int64_t>(max_length)) {
+                throw support::exception(TRACEMSG(
+                        "Invalid frame length: [" + sl::support::to_string(total) + "]," +
+                        " max length: [" + sl::support::to_string(max_length) + "]"));
+            }
+            frame_len = static_cast<size_t>(total);
+            consumed = frame_len;
+            return len >= frame_len;
+        }
+        default: {
+            size_t dlen = delimiter.length();
+            for (size_t i = scan_from; i + dlen <= len; i++) {
+                if (data[i] == delimiter[0] && 0 == delimiter.compare(0, dlen, data + i, dlen)) {
+                    frame_len = include_delimiter ? i + dlen : i;
+                    consumed = i + dlen;
+                    return true;
+                }
+            }
+            // partial delimiter may be at the end
+            scan_from = len >= dlen ? len - dlen + 1 : 0;
+            if (len > max_length) {
+                throw support::exception(TRACEMSG(
+                        "Frame delimiter not found in: [" + sl::support::to_string(len) + "] bytes," +
+                        " max length: [" + sl::support::to_string(max_length) + "]"));
+            }
+            return false;
+        }
+        }
+    }
+
+private:
+    int64_t read_length_field(const char* ptr) const {
+        auto bytes = reinterpret_cast<const unsigned char*>(ptr);
+        uint32_t res = 0;
+        for (uint32_t i = 0; i < width; i++) {
+            uint32_t idx = big_endian ? i : width - 1 - i;
+            res = (res << 8) | bytes[idx];
+        }
+        return static_cast<int64_t>(res);
+    }
+
+    static kind parse_kind(const sl::json::field& fi) {
+        auto& str = fi.as_string_nonempty_or_throw(fi.name());
+        if ("delimiter" == str) {
+            return kind::delimiter;
+        } else if ("fixed" == str) {
+            return kind::fixed;
+        } else if ("lengthPrefix" == str) {
+            return kind::length_prefix;
+        }
+        throw support::exception(TRACEMSG("Invalid 'framing.type' field: [" + str + "]," +
+                " supported values: ['delimiter', 'fixed', 'lengthPrefix']"));
+    }
+
+    static bool parse_endianness(const sl::json::field& fi) {
+        auto& str = fi.as_string_nonempty_or_throw(fi.name());
+        if ("big" == str) {
+            return true;
+        } else if ("little" == str) {
+            return false;
+        }
+        throw support::exception(TRACEMSG("Invalid 'framing.endianness' field: [" + str + "]," +
+                " supported values: ['big', 'little']"));
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_FRAME_SPEC_HPP */
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   handle_pool_libusb.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:07 AM
+ */
+
+#ifndef WILTON_USB_HANDLE_POOL_LIBUSB_HPP
+#define WILTON_USB_HANDLE_POOL_LIBUSB_HPP
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "libusb-1.0/libusb.h"
+
+#include "staticlib/config.hpp"
+#include "staticlib/utils.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Opened device handle with the serial number, that was read once when
+ * the device was opened, so idle handles are matched without device I/O
+ */
+struct pooled_handle {
+    libusb_device_handle* handle = nullptr;
+    std::string serial;
+    // released when the handle is closed
+    std::vector<int> interfaces;
+};
+
+/**
+ * Idle device handles, that are already opened and have interface
+ * claimed, kept by VID/PID to be leased by the next 'pooled' connection
+ * instead of opening and claiming the device again; handles, that were
+ * not leased during their idle timeout, are released and closed
+ */
+class handle_pool_libusb {
+    struct idle_handle {
+        pooled_handle pooled;
+        uint64_t returned_at;
+        uint32_t idle_timeout_millis;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<uint32_t, std::vector<idle_handle>> idle;
+
+public:
+    handle_pool_libusb() { }
+
+    handle_pool_libusb(const handle_pool_libusb&) = delete;
+
+    handle_pool_libusb& operator=(const handle_pool_libusb&) = delete;
+
+    ~handle_pool_libusb() STATICLIB_NOEXCEPT {
+        clear();
+    }
+
+    /**
+     * Returns empty handle if there are no idle handles for this VID/PID
+     * accepted by the predicate, most recently returned handle is leased first;
+     * predicate is called under the pool lock and must not do device I/O
+     */
+    pooled_handle lease(uint16_t vid, uint16_t pid,
+            const std::function<bool(const pooled_handle&)>& accept) {
+        std::lock_guard<std::mutex> guard{mutex};
+        auto it = idle.find(make_key(vid, pid));
+        if (idle.end() == it) {
+            return pooled_handle();
+        }
+        auto& vec = it->second;
+        for (size_t i = vec.size(); i > 0; i--) {
+            if (accept(vec[i - 1].pooled)) {
+                auto res = std::move(vec[i - 1].pooled);
+                vec.erase(vec.begin() + (i - 1));
+                return res;
+            }
+        }
+        return pooled_handle();
+    }
+
+    void give_back(uint16_t vid, uint16_t pid, pooled_handle&& pooled, uint32_t idle_timeout_millis) {
+        idle_handle ih;
+        ih.pooled = std::move(pooled);
+        ih.returned_at = sl::utils::current_time_millis_steady();
+        ih.idle_timeout_millis = idle_timeout_millis;
+        std::lock_guard<std::mutex> guard{mutex};
+        idle[make_key(vid, pid)].push_back(std::move(ih));
+    }
+
+    /**
+     * Closes handles that stayed idle longer than their timeout,
+     * called periodically from the context event thread
+     */
+    void evict_idle() {
+        auto expired = std::vector<pooled_handle>();
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            if (idle.empty()) {
+                return;
+            }
+            uint64_t now = sl::utils::current_time_millis_steady();
+            for (auto it = idle.begin(); it != idle.end();) {
+                auto& vec = it->second;
+                for (size_t i = 0; i < vec.size();) {
+                    if (now - vec[i].returned_at >= vec[i].idle_timeout_millis) {
+                        expired.push_back(std::move(vec[i].pooled));
+                        vec.erase(vec.begin() + i);
+                    } else {
+                        i++;
+                    }
+                }
+                it = vec.empty() ? idle.erase(it) : std::next(it);
+            }
+        }
+        // closed outside of the lock, so leases do not wait for it
+        for (auto& ph : expired) {
+            close_handle(ph.handle, ph.interfaces);
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard{mutex};
+        for (auto& en : idle) {
+            for (auto& ih : en.second) {
+                close_handle(ih.pooled.handle, ih.pooled.interfaces);
+            }
+        }
+        idle.clear();
+    }
+
+    // releases the interfaces claimed through this handle, interface numbers
+    // are not required to be contiguous or to start from zero
+    static void close_handle(libusb_device_handle* ha, const std::vector<int>& interfaces) {
+        for (int num : interfaces) {
+            libusb_release_interface(ha, num);
+        }
+        libusb_close(ha);
+    }
+
+private:
+    static uint32_t make_key(uint16_t vid, uint16_t pid) {
+        return (static_cast<uint32_t>(vid) << 16) | pid;
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_HANDLE_POOL_LIBUSB_HPP */
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   interface_config.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:24 AM
+ */
+
+#ifndef WILTON_USB_INTERFACE_CONFIG_HPP
+#define WILTON_USB_INTERFACE_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Interface to claim on open, specified either as a number
+ * or as an object with 'number' and optional 'altSetting'
+ */
+class interface_config {
+public:
+    uint8_t number = 0;
+    // negative means that alternate setting is not changed
+    int32_t alt_setting = -1;
+
+    interface_config(const interface_config&) = delete;
+
+    interface_config& operator=(const interface_config&) = delete;
+
+    interface_config(interface_config&& other) :
+    number(other.number),
+    alt_setting(other.alt_setting) { }
+
+    interface_config& operator=(interface_config&& other) {
+        number = other.number;
+        alt_setting = other.alt_setting;
+        return *this;
+    }
+
+    interface_config() { }
+
+    interface_config(const sl::json::value& json) {
+        if (sl::json::type::integer == json.json_type()) {
+            this->number = parse_number(json.as_uint16_or_throw("interfaces"));
+            return;
+        }
+        bool number_specified = false;
+        for (const sl::json::field& fi : json.as_object_or_throw("interfaces")) {
+            auto& name = fi.name();
+            if ("number" == name) {
+                this->number = parse_number(fi.as_uint16_or_throw(name));
+                number_specified = true;
+            } else if ("altSetting" == name) {
+                this->alt_setting = fi.as_uint16_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'interfaces' entry field: [" + name + "]"));
+            }
+        }
+        if (!number_specified) throw support::exception(TRACEMSG(
+                "Required parameter 'interfaces.number' not specified"));
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "number", number },
+            { "altSetting", alt_setting }
+        };
+    }
+
+private:
+    static uint8_t parse_number(uint16_t num) {
+        if (num > 255) throw support::exception(TRACEMSG(
+                "Invalid interface number: [" + sl::support::to_string(num) + "]"));
+        return static_cast<uint8_t>(num);
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_INTERFACE_CONFIG_HPP */
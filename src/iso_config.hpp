@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   iso_config.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:04 AM
+ */
+
+#ifndef WILTON_USB_ISO_CONFIG_HPP
+#define WILTON_USB_ISO_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+// limits of the transfers kept in flight, not of the device
+const uint32_t iso_max_transfers = 256;
+const uint32_t iso_max_packets_per_transfer = 1024;
+// same limit as for the 'readAhead' ring
+const uint32_t iso_max_ring_size = 1u << 30;
+
+/**
+ * Streaming parameters for endpoints with 'isochronous' transfer type
+ */
+class iso_config {
+public:
+    uint32_t packets_per_transfer = 8;
+    uint32_t transfers = 4;
+    // zero means max ISO packet size of the endpoint
+    uint32_t packet_size = 0;
+    // zero means 'transfers * packets_per_transfer * 8'
+    uint32_t ring_packets = 0;
+
+    iso_config(const iso_config&) = delete;
+
+    iso_config& operator=(const iso_config&) = delete;
+
+    iso_config(iso_config&& other) :
+    packets_per_transfer(other.packets_per_transfer),
+    transfers(other.transfers),
+    packet_size(other.packet_size),
+    ring_packets(other.ring_packets) { }
+
+    iso_config& operator=(iso_config&& other) {
+        packets_per_transfer = other.packets_per_transfer;
+        transfers = other.transfers;
+        packet_size = other.packet_size;
+        ring_packets = other.ring_packets;
+        return *this;
+    }
+
+    iso_config() { }
+
+    iso_config(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("packetsPerTransfer" == name) {
+                this->packets_per_transfer = fi.as_uint32_positive_or_throw(name);
+            } else if ("transfers" == name) {
+                this->transfers = fi.as_uint32_positive_or_throw(name);
+            } else if ("packetSize" == name) {
+                this->packet_size = fi.as_uint32_positive_or_throw(name);
+            } else if ("ringPackets" == name) {
+                this->ring_packets = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'isochronous' field: [" + name + "]"));
+            }
+        }
+        if (packets_per_transfer > iso_max_packets_per_transfer) throw support::exception(TRACEMSG(
+                "Invalid 'isochronous.packetsPerTransfer' field: [" + sl::support::to_string(packets_per_transfer) + "]," +
+                " max value: [" + sl::support::to_string(iso_max_packets_per_transfer) + "]"));
+        if (transfers > iso_max_transfers) throw support::exception(TRACEMSG(
+                "Invalid 'isochronous.transfers' field: [" + sl::support::to_string(transfers) + "]," +
+                " max value: [" + sl::support::to_string(iso_max_transfers) + "]"));
+    }
+
+    // packet size is known only after the device is opened
+    uint32_t ring_packets_for(uint32_t actual_packet_size) const {
+        uint64_t packets = ring_packets > 0 ? ring_packets :
+                static_cast<uint64_t>(transfers) * packets_per_transfer * 8;
+        uint64_t size = packets * actual_packet_size;
+        if (size > iso_max_ring_size) throw support::exception(TRACEMSG(
+                "Invalid 'isochronous' ring size: [" + sl::support::to_string(size) + "]," +
+                " max size: [" + sl::support::to_string(iso_max_ring_size) + "]," +
+                " 'transfers' or 'packetsPerTransfer' must be reduced, or 'ringPackets' specified"));
+        return static_cast<uint32_t>(packets);
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "packetsPerTransfer", packets_per_transfer },
+            { "transfers", transfers },
+            { "packetSize", packet_size },
+            { "ringPackets", ring_packets }
+        };
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_ISO_CONFIG_HPP */
@@ -0,0 +1,443 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   iso_stream_libusb.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:04 AM
+ */
+
+#ifndef WILTON_USB_ISO_STREAM_LIBUSB_HPP
+#define WILTON_USB_ISO_STREAM_LIBUSB_HPP
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "libusb-1.0/libusb.h"
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/utils.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "spsc_packet_ring.hpp"
+
+namespace wilton {
+namespace usb {
+
+// transfer length is passed to libusb as 'int'
+inline size_t checked_transfer_size(uint32_t packets_per_transfer, uint32_t packet_size) {
+    uint64_t size = static_cast<uint64_t>(packets_per_transfer) * packet_size;
+    if (size > static_cast<uint64_t>(std::numeric_limits<int>::max())) throw support::exception(TRACEMSG(
+            "Invalid 'isochronous' transfer size: [" + sl::support::to_string(size) + "]," +
+            " 'packetsPerTransfer' or 'packetSize' must be reduced"));
+    return static_cast<size_t>(size);
+}
+
+/**
+ * Keeps isochronous IN transfers queued all the time, packets from completed
+ * transfers are pushed with their actual lengths and statuses into
+ * the lock-free ring from the event thread and drained by 'read';
+ * packets are dropped (and counted) when the ring is full; failed
+ * transfers are resubmitted, the stream is stopped with an error only
+ * when the device is gone or transfers keep failing in a row
+ */
+class iso_in_stream_libusb {
+    static const uint32_t max_consecutive_failures = 16;
+
+    spsc_packet_ring ring;
+    std::vector<std::vector<unsigned char>> buffers;
+    std::vector<libusb_transfer*> transfers;
+    // only guards transfers bookkeeping and sleeping, packets do not take the lock
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t in_flight = 0;
+    bool stopping = false;
+    int error_code = LIBUSB_SUCCESS;
+    uint32_t consecutive_failures = 0;
+    std::atomic<uint64_t> packets_dropped;
+    std::atomic<uint64_t> packets_failed;
+    // consumer-only, read position inside the front packet
+    uint32_t front_offset = 0;
+
+public:
+    iso_in_stream_libusb(libusb_device_handle* handle, unsigned char endpoint, uint32_t packets_per_transfer,
+            uint32_t transfers_count, uint32_t packet_size, uint32_t ring_packets) :
+    ring(ring_packets, packet_size),
+    packets_dropped(0),
+    packets_failed(0) {
+        size_t transfer_size = checked_transfer_size(packets_per_transfer, packet_size);
+        buffers.resize(transfers_count);
+        transfers.reserve(transfers_count);
+        for (size_t i = 0; i < transfers_count; i++) {
+            auto tr = libusb_alloc_transfer(static_cast<int>(packets_per_transfer));
+            if (nullptr == tr) {
+                free_transfers();
+                throw support::exception(TRACEMSG("USB 'libusb_alloc_transfer' error"));
+            }
+            transfers.push_back(tr);
+            buffers[i].resize(transfer_size);
+            libusb_fill_iso_transfer(tr, handle, endpoint, buffers[i].data(),
+                    static_cast<int>(buffers[i].size()), static_cast<int>(packets_per_transfer),
+                    iso_in_stream_libusb::on_complete, static_cast<void*>(this), 0);
+            libusb_set_iso_packet_lengths(tr, packet_size);
+        }
+        int err = LIBUSB_SUCCESS;
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            for (libusb_transfer* tr : transfers) {
+                err = libusb_submit_transfer(tr);
+                if (LIBUSB_SUCCESS != err) {
+                    stop_locked();
+                    break;
+                }
+                in_flight += 1;
+            }
+        }
+        if (LIBUSB_SUCCESS != err) {
+            drain();
+            free_transfers();
+            throw support::exception(TRACEMSG(
+                    "USB 'libusb_submit_transfer' error, code: [" + sl::support::to_string(err) + "]"));
+        }
+    }
+
+    iso_in_stream_libusb(const iso_in_stream_libusb&) = delete;
+
+    iso_in_stream_libusb& operator=(const iso_in_stream_libusb&) = delete;
+
+    ~iso_in_stream_libusb() STATICLIB_NOEXCEPT {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            stop_locked();
+        }
+        drain();
+        free_transfers();
+    }
+
+    /**
+     * Payloads of successful packets are concatenated, failed packets are skipped;
+     * returns as soon as 'min_length' bytes are copied to 'dest' or on timeout
+     */
+    size_t read(char* dest, uint32_t length, uint32_t min_length, uint32_t timeout_millis,
+            uint32_t idle_timeout_millis = 0) {
+        uint64_t finish = sl::utils::current_time_millis_steady() + timeout_millis;
+        uint64_t idle_finish = finish;
+        size_t got = 0;
+        for (;;) {
+            size_t count = drain_packets(dest + got, length - got);
+            got += count;
+            if (got >= length || got >= min_length) {
+                break;
+            }
+            if (count > 0 && idle_timeout_millis > 0) {
+                idle_finish = std::min(finish, sl::utils::current_time_millis_steady() + idle_timeout_millis);
+            }
+            std::unique_lock<std::mutex> lock{mutex};
+            if (!ring.empty()) {
+                continue;
+            }
+            if (LIBUSB_SUCCESS != error_code) {
+                if (got > 0) {
+                    break;
+                }
+                throw support::exception(TRACEMSG(
+                        "USB isochronous transfer error, code: [" + sl::support::to_string(error_code) + "]"));
+            }
+            uint64_t cur = sl::utils::current_time_millis_steady();
+            uint64_t deadline = got > 0 ? idle_finish : finish;
+            if (cur >= deadline) {
+                break;
+            }
+            cv.wait_for(lock, std::chrono::milliseconds(deadline - cur));
+        }
+        return got;
+    }
+
+    uint64_t dropped_count() const {
+        return packets_dropped.load(std::memory_order_relaxed);
+    }
+
+    uint64_t failed_count() const {
+        return packets_failed.load(std::memory_order_relaxed);
+    }
+
+private:
+    size_t drain_packets(char* dest, size_t max_len) {
+        size_t got = 0;
+        while (got < max_len) {
+            spsc_packet_ring::packet* pa = ring.front();
+            if (nullptr == pa) {
+                break;
+            }
+            if (LIBUSB_TRANSFER_COMPLETED != pa->status) {
+                packets_failed.fetch_add(1, std::memory_order_relaxed);
+                ring.pop();
+                front_offset = 0;
+                continue;
+            }
+            size_t avail = pa->length - front_offset;
+            size_t count = avail < max_len - got ? avail : max_len - got;
+            if (count > 0) {
+                std::memcpy(dest + got, pa->data.data() + front_offset, count);
+            }
+            got += count;
+            front_offset += static_cast<uint32_t>(count);
+            if (front_offset >= pa->length) {
+                ring.pop();
+                front_offset = 0;
+            }
+        }
+        return got;
+    }
+
+    static void LIBUSB_CALL on_complete(libusb_transfer* tr) {
+        auto self = static_cast<iso_in_stream_libusb*>(tr->user_data);
+        if (LIBUSB_TRANSFER_COMPLETED == tr->status) {
+            for (int i = 0; i < tr->num_iso_packets; i++) {
+                auto& desc = tr->iso_packet_desc[i];
+                auto buf = reinterpret_cast<const char*>(libusb_get_iso_packet_buffer_simple(tr, static_cast<unsigned int>(i)));
+                if (!self->ring.push(buf, desc.actual_length, static_cast<int>(desc.status))) {
+                    self->packets_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> guard{self->mutex};
+        self->in_flight -= 1;
+        if (!self->stopping) {
+            // single failed transfer is resubmitted, its packets are counted as failed
+            if (LIBUSB_TRANSFER_COMPLETED == tr->status) {
+                self->consecutive_failures = 0;
+            } else {
+                self->consecutive_failures += 1;
+                self->packets_failed.fetch_add(static_cast<uint64_t>(tr->num_iso_packets), std::memory_order_relaxed);
+            }
+            if (LIBUSB_TRANSFER_NO_DEVICE == tr->status) {
+                self->error_code = LIBUSB_ERROR_NO_DEVICE;
+            } else if (self->consecutive_failures >= max_consecutive_failures) {
+                self->error_code = LIBUSB_ERROR_IO;
+            } else {
+                auto err = libusb_submit_transfer(tr);
+                if (LIBUSB_SUCCESS == err) {
+                    self->in_flight += 1;
+                } else {
+                    self->error_code = err;
+                }
+            }
+        }
+        self->cv.notify_all();
+    }
+
+    void stop_locked() {
+        stopping = true;
+        for (libusb_transfer* tr : transfers) {
+            libusb_cancel_transfer(tr);
+        }
+    }
+
+    void drain() {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [this] {
+            return 0 == in_flight;
+        });
+    }
+
+    void free_transfers() {
+        for (libusb_transfer* tr : transfers) {
+            libusb_free_transfer(tr);
+        }
+        transfers.clear();
+    }
+};
+
+/**
+ * Splits written data into isochronous transfers of pre-allocated
+ * size and keeps up to the specified number of them in flight
+ */
+class iso_out_stream_libusb {
+    uint32_t packets_per_transfer;
+    uint32_t packet_size;
+    std::vector<std::vector<unsigned char>> buffers;
+    std::vector<libusb_transfer*> transfers;
+    std::vector<libusb_transfer*> free_list;
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t in_flight = 0;
+    bool stopping = false;
+    int error_status = LIBUSB_TRANSFER_COMPLETED;
+    uint64_t completed_bytes = 0;
+
+public:
+    iso_out_stream_libusb(libusb_device_handle* handle, unsigned char endpoint, uint32_t packets_per_transfer,
+            uint32_t transfers_count, uint32_t packet_size) :
+    packets_per_transfer(packets_per_transfer),
+    packet_size(packet_size) {
+        size_t transfer_size = checked_transfer_size(packets_per_transfer, packet_size);
+        buffers.resize(transfers_count);
+        transfers.reserve(transfers_count);
+        for (size_t i = 0; i < transfers_count; i++) {
+            auto tr = libusb_alloc_transfer(static_cast<int>(packets_per_transfer));
+            if (nullptr == tr) {
+                free_transfers();
+                throw support::exception(TRACEMSG("USB 'libusb_alloc_transfer' error"));
+            }
+            transfers.push_back(tr);
+            buffers[i].resize(transfer_size);
+            libusb_fill_iso_transfer(tr, handle, endpoint, buffers[i].data(),
+                    static_cast<int>(buffers[i].size()), static_cast<int>(packets_per_transfer),
+                    iso_out_stream_libusb::on_complete, static_cast<void*>(this), 0);
+        }
+        free_list = transfers;
+    }
+
+    iso_out_stream_libusb(const iso_out_stream_libusb&) = delete;
+
+    iso_out_stream_libusb& operator=(const iso_out_stream_libusb&) = delete;
+
+    ~iso_out_stream_libusb() STATICLIB_NOEXCEPT {
+        std::unique_lock<std::mutex> lock{mutex};
+        stopping = true;
+        for (libusb_transfer* tr : transfers) {
+            libusb_cancel_transfer(tr);
+        }
+        cv.wait(lock, [this] {
+            return 0 == in_flight;
+        });
+        lock.unlock();
+        free_transfers();
+    }
+
+    /**
+     * Returns number of bytes, that were sent before the deadline
+     */
+    size_t write(const char* data, size_t data_len, uint64_t finish) {
+        std::unique_lock<std::mutex> lock{mutex};
+        uint64_t base = completed_bytes;
+        size_t submitted = 0;
+        size_t max_chunk = packets_per_transfer * packet_size;
+        while (submitted < data_len) {
+            if (!wait_until(lock, finish, [this] { return !free_list.empty(); })) {
+                break;
+            }
+            libusb_transfer* tr = free_list.back();
+            free_list.pop_back();
+            size_t chunk = data_len - submitted < max_chunk ? data_len - submitted : max_chunk;
+            std::memcpy(tr->buffer, data + submitted, chunk);
+            size_t packets = (chunk + packet_size - 1) / packet_size;
+            for (size_t i = 0; i < packets; i++) {
+                size_t off = i * packet_size;
+                tr->iso_packet_desc[i].length = static_cast<unsigned int>(
+                        chunk - off < packet_size ? chunk - off : packet_size);
+            }
+            tr->num_iso_packets = static_cast<int>(packets);
+            tr->length = static_cast<int>(chunk);
+            auto err = libusb_submit_transfer(tr);
+            if (LIBUSB_SUCCESS != err) {
+                free_list.push_back(tr);
+                cancel_in_flight(lock);
+                throw support::exception(TRACEMSG(
+                        "USB 'libusb_submit_transfer' error, code: [" + sl::support::to_string(err) + "]"));
+            }
+            in_flight += 1;
+            submitted += chunk;
+        }
+        wait_until(lock, finish, [this] { return 0 == in_flight; });
+        // transfers not completed before the deadline are not carried over to the next write
+        cancel_in_flight(lock);
+        if (LIBUSB_TRANSFER_COMPLETED != error_status) {
+            auto status = error_status;
+            error_status = LIBUSB_TRANSFER_COMPLETED;
+            throw support::exception(TRACEMSG(
+                    "USB isochronous transfer error, status: [" + sl::support::to_string(status) + "]"));
+        }
+        return static_cast<size_t>(completed_bytes - base);
+    }
+
+private:
+    // bytes sent by the cancelled transfers before the cancellation are still counted
+    void cancel_in_flight(std::unique_lock<std::mutex>& lock) {
+        if (0 == in_flight) {
+            return;
+        }
+        for (libusb_transfer* tr : transfers) {
+            if (free_list.end() == std::find(free_list.begin(), free_list.end(), tr)) {
+                libusb_cancel_transfer(tr);
+            }
+        }
+        cv.wait(lock, [this] {
+            return 0 == in_flight;
+        });
+    }
+
+    // returns 'false' if the condition is not met before the deadline or on error
+    template<typename Predicate>
+    bool wait_until(std::unique_lock<std::mutex>& lock, uint64_t finish, Predicate pred) {
+        for (;;) {
+            if (LIBUSB_TRANSFER_COMPLETED != error_status) {
+                return false;
+            }
+            if (pred()) {
+                return true;
+            }
+            uint64_t cur = sl::utils::current_time_millis_steady();
+            if (cur >= finish) {
+                return false;
+            }
+            cv.wait_for(lock, std::chrono::milliseconds(finish - cur));
+        }
+    }
+
+    static void LIBUSB_CALL on_complete(libusb_transfer* tr) {
+        auto self = static_cast<iso_out_stream_libusb*>(tr->user_data);
+        uint64_t sent = 0;
+        for (int i = 0; i < tr->num_iso_packets; i++) {
+            sent += tr->iso_packet_desc[i].actual_length;
+        }
+        std::lock_guard<std::mutex> guard{self->mutex};
+        self->in_flight -= 1;
+        self->completed_bytes += sent;
+        if (LIBUSB_TRANSFER_COMPLETED != tr->status && LIBUSB_TRANSFER_CANCELLED != tr->status) {
+            self->error_status = tr->status;
+        }
+        if (!self->stopping) {
+            self->free_list.push_back(tr);
+        }
+        self->cv.notify_all();
+    }
+
+    void free_transfers() {
+        for (libusb_transfer* tr : transfers) {
+            libusb_free_transfer(tr);
+        }
+        transfers.clear();
+        free_list.clear();
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_ISO_STREAM_LIBUSB_HPP */
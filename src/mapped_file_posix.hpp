@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   mapped_file_posix.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:29 AM
+ */
+
+#ifndef WILTON_USB_MAPPED_FILE_POSIX_HPP
+#define WILTON_USB_MAPPED_FILE_POSIX_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Mapping of the whole file: read-only mapping of the existing file,
+ * so its contents are passed to the transfers without loading it into
+ * memory, or read-write mapping of the new file of the fixed capacity,
+ * so the device data is read into it directly; read-write file is
+ * truncated to the size set with 'truncate_on_close'
+ */
+class mapped_file {
+    std::string path;
+    int fd = -1;
+    char* base = nullptr;
+    size_t length = 0;
+    bool writable = false;
+    size_t final_length = 0;
+
+public:
+    explicit mapped_file(const std::string& path) :
+    path(path) {
+        this->fd = ::open(path.c_str(), O_RDONLY);
+        if (-1 == fd) throw support::exception(TRACEMSG(
+                "Error opening file, path: [" + path + "], error: [" + ::strerror(errno) + "]"));
+        struct stat st;
+        if (-1 == ::fstat(fd, std::addressof(st))) {
+            auto err = std::string(::strerror(errno));
+            ::close(fd);
+            throw support::exception(TRACEMSG(
+                    "Error reading file size, path: [" + path + "], error: [" + err + "]"));
+        }
+        this->length = static_cast<size_t>(st.st_size);
+        if (0 == length) {
+            ::close(fd);
+            throw support::exception(TRACEMSG("Specified file is empty, path: [" + path + "]"));
+        }
+        map(PROT_READ);
+        // file is read once from start to end
+        ::madvise(base, length, MADV_SEQUENTIAL);
+    }
+
+    mapped_file(const std::string& path, size_t capacity) :
+    path(path),
+    length(capacity),
+    writable(true),
+    final_length(capacity) {
+        this->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (-1 == fd) throw support::exception(TRACEMSG(
+                "Error opening file, path: [" + path + "], error: [" + ::strerror(errno) + "]"));
+        if (-1 == ::ftruncate(fd, static_cast<off_t>(capacity))) {
+            auto err = std::string(::strerror(errno));
+            ::close(fd);
+            throw support::exception(TRACEMSG(
+                    "Error sizing file, path: [" + path + "]," +
+                    " size: [" + sl::support::to_string(capacity) + "], error: [" + err + "]"));
+        }
+        map(PROT_READ | PROT_WRITE);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() STATICLIB_NOEXCEPT {
+        ::munmap(base, length);
+        if (writable && final_length < length) {
+            auto err = ::ftruncate(fd, static_cast<off_t>(final_length));
+            (void) err;
+        }
+        ::close(fd);
+    }
+
+    const std::string& file_path() const {
+        return path;
+    }
+
+    const char* data() const {
+        return base;
+    }
+
+    // only with the read-write mapping
+    char* writable_data() {
+        return base;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    void truncate_on_close(size_t size) {
+        this->final_length = size;
+    }
+
+private:
+    void map(int prot) {
+        void* addr = ::mmap(nullptr, length, prot, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == addr) {
+            auto err = std::string(::strerror(errno));
+            ::close(fd);
+            throw support::exception(TRACEMSG(
+                    "Error mapping file, path: [" + path + "], error: [" + err + "]"));
+        }
+        this->base = static_cast<char*>(addr);
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_MAPPED_FILE_POSIX_HPP */
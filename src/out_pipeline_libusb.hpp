@@ -0,0 +1,180 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   out_pipeline_libusb.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:29 AM
+ */
+
+#ifndef WILTON_USB_OUT_PIPELINE_LIBUSB_HPP
+#define WILTON_USB_OUT_PIPELINE_LIBUSB_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "libusb-1.0/libusb.h"
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "file_write_progress.hpp"
+#include "transfer_type.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Sends a large buffer to the OUT endpoint as a sequence of chunks, keeping
+ * a fixed number of transfers in flight; transfers are completed by the
+ * context event thread and resubmitted from the calling thread, chunks
+ * point directly into the caller memory
+ */
+class out_pipeline_libusb {
+    libusb_device_handle* handle;
+    unsigned char endpoint;
+    transfer_type ttype;
+    unsigned int timeout_millis;
+    file_write_progress& progress;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<libusb_transfer*> transfers;
+    std::vector<libusb_transfer*> idle;
+    uint32_t in_flight = 0;
+    std::string error;
+
+public:
+    out_pipeline_libusb(libusb_device_handle* handle, unsigned char endpoint, transfer_type ttype,
+            uint32_t depth, unsigned int timeout_millis, file_write_progress& progress) :
+    handle(handle),
+    endpoint(endpoint),
+    ttype(ttype),
+    timeout_millis(timeout_millis),
+    progress(progress) {
+        for (uint32_t i = 0; i < depth; i++) {
+            auto tr = libusb_alloc_transfer(0);
+            if (nullptr == tr) {
+                free_transfers();
+                throw support::exception(TRACEMSG("USB 'libusb_alloc_transfer' error"));
+            }
+            transfers.push_back(tr);
+        }
+        idle = transfers;
+    }
+
+    out_pipeline_libusb(const out_pipeline_libusb&) = delete;
+
+    out_pipeline_libusb& operator=(const out_pipeline_libusb&) = delete;
+
+    ~out_pipeline_libusb() STATICLIB_NOEXCEPT {
+        free_transfers();
+    }
+
+    /**
+     * Blocks until all the data is written, 'chunk' must be a multiple
+     * of the max packet size, so only the last transfer can end with
+     * a short packet; ZLP is sent after the data that ends on the packet
+     * boundary, if 'zlp' is requested
+     */
+    void run(const char* data, size_t len, size_t chunk, bool zlp) {
+        size_t offset = 0;
+        bool zlp_pending = zlp;
+        bool cancelled = false;
+        std::unique_lock<std::mutex> lock{mutex};
+        for (;;) {
+            while (error.empty() && !idle.empty() && (offset < len || zlp_pending)) {
+                size_t count = std::min(chunk, len - offset);
+                if (0 == count) {
+                    zlp_pending = false;
+                }
+                auto tr = idle.back();
+                idle.pop_back();
+                fill(tr, data + offset, count);
+                auto err = libusb_submit_transfer(tr);
+                if (LIBUSB_SUCCESS != err) {
+                    idle.push_back(tr);
+                    error = "USB 'libusb_submit_transfer' error, code: [" + sl::support::to_string(err) + "]";
+                    break;
+                }
+                offset += count;
+                in_flight += 1;
+                progress.set_in_flight(in_flight);
+            }
+            if (0 == in_flight && (!error.empty() || (offset >= len && !zlp_pending))) {
+                break;
+            }
+            if (!error.empty() && !cancelled) {
+                // idle transfers report 'LIBUSB_ERROR_NOT_FOUND' here
+                for (libusb_transfer* tr : transfers) {
+                    libusb_cancel_transfer(tr);
+                }
+                cancelled = true;
+            }
+            cv.wait(lock);
+        }
+        if (!error.empty()) throw support::exception(TRACEMSG(error +
+                ", bytes written: [" + sl::support::to_string(progress.written()) + "]"));
+    }
+
+private:
+    void fill(libusb_transfer* tr, const char* ptr, size_t count) {
+        // libusb does not modify the OUT buffer
+        auto buf = reinterpret_cast<unsigned char*>(const_cast<char*>(ptr));
+        if (transfer_type::interrupt == ttype) {
+            libusb_fill_interrupt_transfer(tr, handle, endpoint, buf, static_cast<int>(count),
+                    out_pipeline_libusb::on_complete, static_cast<void*>(this), timeout_millis);
+        } else {
+            libusb_fill_bulk_transfer(tr, handle, endpoint, buf, static_cast<int>(count),
+                    out_pipeline_libusb::on_complete, static_cast<void*>(this), timeout_millis);
+        }
+    }
+
+    void free_transfers() {
+        for (libusb_transfer* tr : transfers) {
+            libusb_free_transfer(tr);
+        }
+        transfers.clear();
+    }
+
+    static void LIBUSB_CALL on_complete(libusb_transfer* tr) {
+        auto self = static_cast<out_pipeline_libusb*>(tr->user_data);
+        std::lock_guard<std::mutex> guard{self->mutex};
+        self->progress.add_written(static_cast<uint64_t>(tr->actual_length));
+        bool complete = LIBUSB_TRANSFER_COMPLETED == tr->status && tr->actual_length == tr->length;
+        if (!complete && self->error.empty()) {
+            self->error = "USB OUT transfer error, status: [" + sl::support::to_string(static_cast<int>(tr->status)) + "]," +
+                    " bytes transferred: [" + sl::support::to_string(tr->actual_length) + "]," +
+                    " requested: [" + sl::support::to_string(tr->length) + "]";
+        }
+        self->in_flight -= 1;
+        self->progress.set_in_flight(self->in_flight);
+        self->idle.push_back(tr);
+        self->cv.notify_all();
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_OUT_PIPELINE_LIBUSB_HPP */
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   payload_tracer.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 8:56 AM
+ */
+
+#ifndef WILTON_USB_PAYLOAD_TRACER_HPP
+#define WILTON_USB_PAYLOAD_TRACER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/wilton.h"
+#include "wilton/wilton_logging.h"
+
+#include "trace_config.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Decides whether an operation is traced before any log message
+ * is formatted, and formats bounded payload dumps for traced operations
+ */
+class payload_tracer {
+    std::string logger;
+    uint32_t max_bytes;
+    uint32_t sample_every;
+    std::atomic<uint64_t> counter;
+
+public:
+    payload_tracer(const std::string& logger, const trace_config& conf) :
+    logger(logger),
+    max_bytes(conf.max_bytes),
+    sample_every(conf.sample_every),
+    counter(0) { }
+
+    payload_tracer(const payload_tracer&) = delete;
+
+    payload_tracer& operator=(const payload_tracer&) = delete;
+
+    /**
+     * Must be called once per operation, returns 'true' if
+     * the operation must be traced
+     */
+    bool begin() {
+        if (!debug_enabled()) {
+            return false;
+        }
+        if (1 == sample_every) {
+            return true;
+        }
+        return 0 == counter.fetch_add(1, std::memory_order_relaxed) % sample_every;
+    }
+
+    std::string dump(const char* data, size_t len) const {
+        if (len <= max_bytes) {
+            return sl::io::format_plain_as_hex(std::string(data, len));
+        }
+        return sl::io::format_plain_as_hex(std::string(data, max_bytes)) +
+                " ... (" + sl::support::to_string(len - max_bytes) + " more bytes)";
+    }
+
+    std::string dump(const std::string& data) const {
+        return dump(data.data(), data.length());
+    }
+
+private:
+    bool debug_enabled() const {
+        static const std::string level = "DEBUG";
+        int res = 0;
+        char* err = wilton_logger_is_level_enabled(logger.c_str(), static_cast<int>(logger.length()),
+                level.c_str(), static_cast<int>(level.length()), std::addressof(res));
+        if (nullptr != err) {
+            wilton_free(err);
+            return false;
+        }
+        return 0 != res;
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_PAYLOAD_TRACER_HPP */
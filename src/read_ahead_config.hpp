@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   read_ahead_config.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 8:55 AM
+ */
+
+#ifndef WILTON_USB_READ_AHEAD_CONFIG_HPP
+#define WILTON_USB_READ_AHEAD_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+// same limit as for 'bufferSize', ring is allocated once per device
+const uint32_t read_ahead_max_ring_size = 1u << 30;
+
+/**
+ * Streaming mode for IN endpoint: when 'transfers' is non-zero,
+ * this number of IN transfers is kept queued on the device all the time
+ * and received data is accumulated in a bounded ring buffer that is
+ * drained by 'read' calls; with interrupt IN endpoint this works as
+ * a background poller that does not miss report intervals
+ */
+class read_ahead_config {
+public:
+    uint32_t transfers = 0;
+    // zero means 16384 for bulk and max packet size for interrupt endpoint
+    uint32_t transfer_size = 0;
+    // zero means 'transfers * transfer_size * 4'
+    uint32_t ring_size = 0;
+
+    read_ahead_config(const read_ahead_config&) = delete;
+
+    read_ahead_config& operator=(const read_ahead_config&) = delete;
+
+    read_ahead_config(read_ahead_config&& other) :
+    transfers(other.transfers),
+    transfer_size(other.transfer_size),
+    ring_size(other.ring_size) { }
+
+    read_ahead_config& operator=(read_ahead_config&& other) {
+        transfers = other.transfers;
+        transfer_size = other.transfer_size;
+        ring_size = other.ring_size;
+        return *this;
+    }
+
+    read_ahead_config() { }
+
+    read_ahead_config(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("transfers" == name) {
+                this->transfers = fi.as_uint32_positive_or_throw(name);
+            } else if ("transferSize" == name) {
+                this->transfer_size = fi.as_uint32_positive_or_throw(name);
+            } else if ("ringSize" == name) {
+                this->ring_size = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'readAhead' field: [" + name + "]"));
+            }
+        }
+        if (0 == transfers) throw support::exception(TRACEMSG(
+                "Invalid 'readAhead.transfers' field: []"));
+        if (ring_size > read_ahead_max_ring_size) throw support::exception(TRACEMSG(
+                "Invalid 'readAhead.ringSize' field: [" + sl::support::to_string(ring_size) + "]," +
+                " max size: [" + sl::support::to_string(read_ahead_max_ring_size) + "]"));
+    }
+
+    bool enabled() const {
+        return transfers > 0;
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "transfers", transfers },
+            { "transferSize", transfer_size },
+            { "ringSize", ring_size }
+        };
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_READ_AHEAD_CONFIG_HPP */
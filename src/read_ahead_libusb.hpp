@@ -0,0 +1,246 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   read_ahead_libusb.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 8:55 AM
+ */
+
+#ifndef WILTON_USB_READ_AHEAD_LIBUSB_HPP
+#define WILTON_USB_READ_AHEAD_LIBUSB_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "libusb-1.0/libusb.h"
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/utils.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "byte_ring.hpp"
+#include "transfer_type.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Keeps a fixed number of asynchronous IN transfers queued on the endpoint,
+ * completed transfers are copied into the ring buffer and resubmitted immediately;
+ * when the ring is full, completed transfers are held back until 'read'
+ * frees enough space for them
+ */
+class read_ahead_libusb {
+    std::mutex mutex;
+    std::condition_variable cv;
+    byte_ring ring;
+    std::vector<std::vector<unsigned char>> buffers;
+    std::vector<libusb_transfer*> transfers;
+    std::deque<libusb_transfer*> stalled;
+    size_t in_flight = 0;
+    bool stopping = false;
+    int error_status = LIBUSB_TRANSFER_COMPLETED;
+    int error_code = LIBUSB_SUCCESS;
+
+public:
+    read_ahead_libusb(libusb_device_handle* handle, unsigned char endpoint, transfer_type ttype,
+            uint32_t transfers_count, uint32_t transfer_size, uint32_t ring_size) :
+    ring(ring_size) {
+        buffers.resize(transfers_count);
+        transfers.reserve(transfers_count);
+        for (size_t i = 0; i < transfers_count; i++) {
+            auto tr = libusb_alloc_transfer(0);
+            if (nullptr == tr) {
+                free_transfers();
+                throw support::exception(TRACEMSG("USB 'libusb_alloc_transfer' error"));
+            }
+            transfers.push_back(tr);
+            buffers[i].resize(transfer_size);
+            if (transfer_type::interrupt == ttype) {
+                libusb_fill_interrupt_transfer(tr, handle, endpoint, buffers[i].data(),
+                        static_cast<int>(transfer_size), read_ahead_libusb::on_complete,
+                        static_cast<void*>(this), 0);
+            } else {
+                libusb_fill_bulk_transfer(tr, handle, endpoint, buffers[i].data(),
+                        static_cast<int>(transfer_size), read_ahead_libusb::on_complete,
+                        static_cast<void*>(this), 0);
+            }
+        }
+        int err = LIBUSB_SUCCESS;
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            for (libusb_transfer* tr : transfers) {
+                submit_locked(tr);
+                if (LIBUSB_SUCCESS != error_code) {
+                    err = error_code;
+                    stop_locked();
+                    break;
+                }
+            }
+        }
+        if (LIBUSB_SUCCESS != err) {
+            drain();
+            free_transfers();
+            throw support::exception(TRACEMSG(
+                    "USB 'libusb_submit_transfer' error, code: [" + sl::support::to_string(err) + "]"));
+        }
+    }
+
+    read_ahead_libusb(const read_ahead_libusb&) = delete;
+
+    read_ahead_libusb& operator=(const read_ahead_libusb&) = delete;
+
+    ~read_ahead_libusb() STATICLIB_NOEXCEPT {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            stop_locked();
+        }
+        drain();
+        free_transfers();
+    }
+
+    /**
+     * Returns as soon as 'min_length' bytes are available, copies
+     * all the buffered data up to 'length' into 'dest', or on timeout
+     */
+    size_t read(char* dest, uint32_t length, uint32_t min_length, uint32_t timeout_millis,
+            uint32_t idle_timeout_millis = 0) {
+        uint64_t start = sl::utils::current_time_millis_steady();
+        uint64_t finish = start + timeout_millis;
+        uint64_t idle_finish = finish;
+        size_t got = 0;
+        std::unique_lock<std::mutex> lock{mutex};
+        for (;;) {
+            size_t count = ring.read(dest + got, length - got);
+            got += count;
+            resubmit_stalled_locked();
+            if (got >= length || got >= min_length) {
+                break;
+            }
+            if (count > 0 && idle_timeout_millis > 0) {
+                idle_finish = std::min(finish, sl::utils::current_time_millis_steady() + idle_timeout_millis);
+            }
+            if (ring.empty() && stalled.empty() && failed_locked()) {
+                if (got > 0) {
+                    break;
+                }
+                throw support::exception(TRACEMSG(
+                        "USB read-ahead transfer error, status: [" + sl::support::to_string(error_status) + "]," +
+                        " code: [" + sl::support::to_string(error_code) + "]"));
+            }
+            uint64_t cur = sl::utils::current_time_millis_steady();
+            uint64_t deadline = got > 0 ? idle_finish : finish;
+            if (cur >= deadline) {
+                break;
+            }
+            // completions are delivered by the context event thread
+            cv.wait_for(lock, std::chrono::milliseconds(deadline - cur));
+        }
+        return got;
+    }
+
+private:
+    static void LIBUSB_CALL on_complete(libusb_transfer* tr) {
+        auto self = static_cast<read_ahead_libusb*>(tr->user_data);
+        std::lock_guard<std::mutex> guard{self->mutex};
+        self->in_flight -= 1;
+        self->cv.notify_all();
+        if (self->stopping) {
+            return;
+        }
+        switch (tr->status) {
+        case LIBUSB_TRANSFER_COMPLETED:
+        case LIBUSB_TRANSFER_TIMED_OUT: {
+            auto len = static_cast<size_t>(tr->actual_length);
+            if (self->stalled.empty() && self->ring.available() >= len) {
+                self->ring.write(reinterpret_cast<const char*>(tr->buffer), len);
+                self->submit_locked(tr);
+            } else {
+                self->stalled.push_back(tr);
+            }
+            break;
+        }
+        default:
+            self->error_status = tr->status;
+        }
+    }
+
+    void submit_locked(libusb_transfer* tr) {
+        auto err = libusb_submit_transfer(tr);
+        if (LIBUSB_SUCCESS == err) {
+            in_flight += 1;
+        } else {
+            error_code = err;
+        }
+    }
+
+    void resubmit_stalled_locked() {
+        while (!stopping && !stalled.empty()) {
+            libusb_transfer* tr = stalled.front();
+            auto len = static_cast<size_t>(tr->actual_length);
+            if (ring.available() < len) {
+                break;
+            }
+            ring.write(reinterpret_cast<const char*>(tr->buffer), len);
+            stalled.pop_front();
+            submit_locked(tr);
+        }
+    }
+
+    bool failed_locked() {
+        return LIBUSB_TRANSFER_COMPLETED != error_status || LIBUSB_SUCCESS != error_code;
+    }
+
+    void stop_locked() {
+        stopping = true;
+        stalled.clear();
+        for (libusb_transfer* tr : transfers) {
+            // not-in-flight transfers report 'LIBUSB_ERROR_NOT_FOUND' here
+            libusb_cancel_transfer(tr);
+        }
+    }
+
+    // cancelled transfers must complete before they can be freed
+    void drain() {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [this] {
+            return 0 == in_flight;
+        });
+    }
+
+    void free_transfers() {
+        for (libusb_transfer* tr : transfers) {
+            libusb_free_transfer(tr);
+        }
+        transfers.clear();
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_READ_AHEAD_LIBUSB_HPP */
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   read_completion_config.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:14 AM
+ */
+
+#ifndef WILTON_USB_READ_COMPLETION_CONFIG_HPP
+#define WILTON_USB_READ_COMPLETION_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Rules for finishing 'read' before the requested length is received,
+ * similar to termios VMIN/VTIME: 'shortPacket' returns when the device
+ * ends the transfer with a short (or zero-length) packet, 'minLength'
+ * returns as soon as this number of bytes is received, and
+ * 'idleTimeoutMillis' returns when no more data arrives within
+ * this interval after the first byte; 'timeoutMillis' remains
+ * the overall deadline
+ */
+class read_completion_config {
+public:
+    bool short_packet = false;
+    // zero means the requested length
+    uint32_t min_length = 0;
+    // zero means that only the overall timeout is used
+    uint32_t idle_timeout_millis = 0;
+
+    read_completion_config(const read_completion_config&) = delete;
+
+    read_completion_config& operator=(const read_completion_config&) = delete;
+
+    read_completion_config(read_completion_config&& other) :
+    short_packet(other.short_packet),
+    min_length(other.min_length),
+    idle_timeout_millis(other.idle_timeout_millis) { }
+
+    read_completion_config& operator=(read_completion_config&& other) {
+        short_packet = other.short_packet;
+        min_length = other.min_length;
+        idle_timeout_millis = other.idle_timeout_millis;
+        return *this;
+    }
+
+    read_completion_config() { }
+
+    read_completion_config(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("shortPacket" == name) {
+                this->short_packet = fi.as_bool_or_throw(name);
+            } else if ("minLength" == name) {
+                this->min_length = fi.as_uint32_positive_or_throw(name);
+            } else if ("idleTimeoutMillis" == name) {
+                this->idle_timeout_millis = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'readCompletion' field: [" + name + "]"));
+            }
+        }
+    }
+
+    uint32_t min_length_for(uint32_t length) const {
+        return min_length > 0 && min_length < length ? min_length : length;
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "shortPacket", short_packet },
+            { "minLength", min_length },
+            { "idleTimeoutMillis", idle_timeout_millis }
+        };
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_READ_COMPLETION_CONFIG_HPP */
@@ -0,0 +1,342 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   script_engine.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:21 AM
+ */
+
+#ifndef WILTON_USB_SCRIPT_ENGINE_HPP
+#define WILTON_USB_SCRIPT_ENGINE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "connection.hpp"
+#include "frame_spec.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Runs declarative device procedures (write, read, expect, delay,
+ * loop, capture) against the connection within a single native call;
+ * the whole script is parsed and validated before the first step is run,
+ * captured variables hold binary data and are returned as hex
+ */
+class script_engine {
+    enum class step_kind { write, read, expect, delay, loop, capture, end };
+
+    struct step {
+        step_kind kind = step_kind::end;
+        std::string label;
+        // write: hex with '${name}' variable references
+        std::string data_hex;
+        // read: fixed length or framing, framing is also used for 'untilHex'
+        uint32_t length = 0;
+        frame_spec framing;
+        // read, capture: variable name
+        std::string name;
+        // expect, capture: source variable
+        std::string source = "last";
+        // expect
+        std::string pattern;
+        std::string on_mismatch;
+        // delay
+        uint32_t millis = 0;
+        // loop
+        uint32_t count = 0;
+        bool until_empty = false;
+        std::vector<step> steps;
+        // capture
+        uint32_t offset = 0;
+    };
+
+    // outcome of the step list
+    enum class flow { next, end };
+
+    std::vector<step> steps;
+    uint32_t max_steps = 100000;
+
+    // run state
+    std::map<std::string, std::string> vars;
+    uint32_t executed = 0;
+    bool got_empty = false;
+
+public:
+    script_engine(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("steps" == name) {
+                this->steps = parse_steps(fi.val());
+            } else if ("maxSteps" == name) {
+                this->max_steps = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'script' field: [" + name + "]"));
+            }
+        }
+        if (steps.empty()) throw support::exception(TRACEMSG(
+                "Required parameter 'script.steps' not specified"));
+    }
+
+    script_engine(const script_engine&) = delete;
+
+    script_engine& operator=(const script_engine&) = delete;
+
+    /**
+     * Returns '{"variables": {...}, "stepsExecuted": N}',
+     * 'last' variable holds the data of the last read
+     */
+    sl::json::value run(connection& conn) {
+        vars.clear();
+        executed = 0;
+        run_steps(conn, steps);
+        auto vars_json = std::vector<sl::json::field>();
+        for (auto& en : vars) {
+            vars_json.emplace_back(en.first, sl::io::string_to_hex(en.second));
+        }
+        return {
+            { "variables", std::move(vars_json) },
+            { "stepsExecuted", executed }
+        };
+    }
+
+private:
+    flow run_steps(connection& conn, const std::vector<step>& list) {
+        size_t i = 0;
+        while (i < list.size()) {
+            auto& st = list[i];
+            executed += 1;
+            if (executed > max_steps) throw support::exception(TRACEMSG(
+                    "Script steps limit exceeded, limit: [" + sl::support::to_string(max_steps) + "]"));
+            switch (st.kind) {
+            case step_kind::write: {
+                auto data = sl::io::string_from_hex(substitute(st.data_hex));
+                conn.write(sl::io::make_span(data.data(), data.length()));
+                break;
+            }
+            case step_kind::read: {
+                auto res = st.length > 0 ? conn.read(st.length) : conn.read_frame(st.framing);
+                if (res.empty()) {
+                    got_empty = true;
+                }
+                if (!st.name.empty()) {
+                    vars[st.name] = res;
+                }
+                vars["last"] = std::move(res);
+                break;
+            }
+            case step_kind::expect: {
+                if (std::string::npos == variable(st.source).find(st.pattern)) {
+                    if (st.on_mismatch.empty()) throw support::exception(TRACEMSG(
+                            "Script expectation failed, step: [" + sl::support::to_string(i) + "]," +
+                            " pattern: [" + sl::io::string_to_hex(st.pattern) + "]," +
+                            " data: [" + sl::io::string_to_hex(variable(st.source)) + "]"));
+                    i = find_label(list, st.on_mismatch);
+                    continue;
+                }
+                break;
+            }
+            case step_kind::delay:
+                std::this_thread::sleep_for(std::chrono::milliseconds(st.millis));
+                break;
+            case step_kind::loop: {
+                // flag of the enclosing loop is restored, empty read is passed
+                // to it only if this loop does not stop on it
+                bool outer_empty = got_empty;
+                for (uint32_t iter = 0; 0 == st.count || iter < st.count; iter++) {
+                    got_empty = false;
+                    if (flow::end == run_steps(conn, st.steps)) {
+                        return flow::end;
+                    }
+                    if (st.until_empty && got_empty) {
+                        break;
+                    }
+                }
+                got_empty = outer_empty || (!st.until_empty && got_empty);
+                break;
+            }
+            case step_kind::capture: {
+                auto& src = variable(st.source);
+                if (st.offset > src.length()) throw support::exception(TRACEMSG(
+                        "Script capture offset out of range, step: [" + sl::support::to_string(i) + "]," +
+                        " offset: [" + sl::support::to_string(st.offset) + "]," +
+                        " data length: [" + sl::support::to_string(src.length()) + "]"));
+                size_t len = st.length > 0 ? st.length : std::string::npos;
+                vars[st.name] = src.substr(st.offset, len);
+                break;
+            }
+            case step_kind::end:
+                return flow::end;
+            }
+            i += 1;
+        }
+        return flow::next;
+    }
+
+    const std::string& variable(const std::string& name) {
+        auto it = vars.find(name);
+        if (vars.end() == it) throw support::exception(TRACEMSG(
+                "Script variable not defined: [" + name + "]"));
+        return it->second;
+    }
+
+    std::string substitute(const std::string& hex) {
+        auto res = std::string();
+        size_t pos = 0;
+        for (;;) {
+            size_t start = hex.find("${", pos);
+            if (std::string::npos == start) {
+                res.append(hex, pos, std::string::npos);
+                return res;
+            }
+            size_t end = hex.find('}', start);
+            if (std::string::npos == end) throw support::exception(TRACEMSG(
+                    "Invalid variable reference in 'dataHex': [" + hex + "]"));
+            res.append(hex, pos, start - pos);
+            res.append(sl::io::string_to_hex(variable(hex.substr(start + 2, end - start - 2))));
+            pos = end + 1;
+        }
+    }
+
+    static size_t find_label(const std::vector<step>& list, const std::string& label) {
+        for (size_t i = 0; i < list.size(); i++) {
+            if (label == list[i].label) {
+                return i;
+            }
+        }
+        throw support::exception(TRACEMSG("Script label not found: [" + label + "]"));
+    }
+
+    static std::vector<step> parse_steps(const sl::json::value& json) {
+        auto res = std::vector<step>();
+        for (auto& val : json.as_array_or_throw("steps")) {
+            res.emplace_back(parse_step(val));
+        }
+        // jumps are only allowed within the same list
+        for (auto& st : res) {
+            if (!st.on_mismatch.empty()) {
+                find_label(res, st.on_mismatch);
+            }
+        }
+        return res;
+    }
+
+    static step parse_step(const sl::json::value& json) {
+        auto res = step();
+        auto op = std::string();
+        auto until_hex = std::string();
+        const sl::json::value* framing = nullptr;
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("op" == name) {
+                op = fi.as_string_nonempty_or_throw(name);
+            } else if ("label" == name) {
+                res.label = fi.as_string_nonempty_or_throw(name);
+            } else if ("dataHex" == name) {
+                res.data_hex = fi.as_string_nonempty_or_throw(name);
+            } else if ("length" == name) {
+                res.length = fi.as_uint32_positive_or_throw(name);
+            } else if ("framing" == name) {
+                framing = std::addressof(fi.val());
+            } else if ("untilHex" == name) {
+                until_hex = fi.as_string_nonempty_or_throw(name);
+            } else if ("name" == name) {
+                res.name = fi.as_string_nonempty_or_throw(name);
+            } else if ("source" == name) {
+                res.source = fi.as_string_nonempty_or_throw(name);
+            } else if ("patternHex" == name) {
+                res.pattern = sl::io::string_from_hex(fi.as_string_nonempty_or_throw(name));
+            } else if ("onMismatch" == name) {
+                res.on_mismatch = fi.as_string_nonempty_or_throw(name);
+            } else if ("millis" == name) {
+                res.millis = fi.as_uint32_positive_or_throw(name);
+            } else if ("count" == name) {
+                res.count = fi.as_uint32_positive_or_throw(name);
+            } else if ("untilEmpty" == name) {
+                res.until_empty = fi.as_bool_or_throw(name);
+            } else if ("steps" == name) {
+                res.steps = parse_steps(fi.val());
+            } else if ("offset" == name) {
+                res.offset = fi.as_uint32_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'script.steps' entry field: [" + name + "]"));
+            }
+        }
+        if ("write" == op) {
+            res.kind = step_kind::write;
+            if (res.data_hex.empty()) throw support::exception(TRACEMSG(
+                    "Required parameter 'dataHex' not specified for 'write' step"));
+        } else if ("read" == op) {
+            res.kind = step_kind::read;
+            int specified = (res.length > 0 ? 1 : 0) + (nullptr != framing ? 1 : 0) + (!until_hex.empty() ? 1 : 0);
+            if (1 != specified) throw support::exception(TRACEMSG(
+                    "Exactly one of 'length', 'framing' or 'untilHex' must be specified for 'read' step"));
+            // parsed here, so the script does not fail half-way
+            if (nullptr != framing) {
+                res.framing = frame_spec(*framing);
+            } else if (!until_hex.empty()) {
+                res.framing = frame_spec({
+                    { "type", "delimiter" },
+                    { "delimiterHex", until_hex },
+                    { "includeDelimiter", true }
+                });
+            }
+        } else if ("expect" == op) {
+            res.kind = step_kind::expect;
+            if (res.pattern.empty()) throw support::exception(TRACEMSG(
+                    "Required parameter 'patternHex' not specified for 'expect' step"));
+        } else if ("delay" == op) {
+            res.kind = step_kind::delay;
+            if (0 == res.millis) throw support::exception(TRACEMSG(
+                    "Required parameter 'millis' not specified for 'delay' step"));
+        } else if ("loop" == op) {
+            res.kind = step_kind::loop;
+            if (res.steps.empty()) throw support::exception(TRACEMSG(
+                    "Required parameter 'steps' not specified for 'loop' step"));
+            if (0 == res.count && !res.until_empty) throw support::exception(TRACEMSG(
+                    "Parameter 'count' or 'untilEmpty' must be specified for 'loop' step"));
+        } else if ("capture" == op) {
+            res.kind = step_kind::capture;
+            if (res.name.empty()) throw support::exception(TRACEMSG(
+                    "Required parameter 'name' not specified for 'capture' step"));
+        } else if ("end" == op) {
+            res.kind = step_kind::end;
+        } else {
+            throw support::exception(TRACEMSG("Invalid 'op' field: [" + op + "]," +
+                    " supported values: ['write', 'read', 'expect', 'delay', 'loop', 'capture', 'end']"));
+        }
+        return res;
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_SCRIPT_ENGINE_HPP */
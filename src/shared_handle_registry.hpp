@@ -0,0 +1,136 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   shared_handle_registry.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 8:58 AM
+ */
+
+#ifndef WILTON_USB_SHARED_HANDLE_REGISTRY_HPP
+#define WILTON_USB_SHARED_HANDLE_REGISTRY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "staticlib/config.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Handle table that hands out shared references to registered objects,
+ * so the same handle can be used from multiple threads at the same time;
+ * object is destroyed when it is removed from the table and the last
+ * outstanding reference is released. Table is split into independently
+ * locked stripes, so lookups of unrelated handles do not contend.
+ */
+template<typename T>
+class shared_handle_registry {
+    struct stripe {
+        std::mutex mutex;
+        std::unordered_map<int64_t, std::shared_ptr<T>> objects;
+    };
+
+    std::array<stripe, 16> stripes;
+    std::atomic<int64_t> counter;
+    std::function<void(T*)> deleter;
+
+public:
+    explicit shared_handle_registry(std::function<void(T*)> deleter) :
+    counter(0),
+    deleter(std::move(deleter)) { }
+
+    shared_handle_registry(const shared_handle_registry&) = delete;
+
+    shared_handle_registry& operator=(const shared_handle_registry&) = delete;
+
+    int64_t put(T* obj) {
+        auto ptr = std::shared_ptr<T>(obj, deleter);
+        int64_t handle = counter.fetch_add(1) + 1;
+        auto& st = stripe_for(handle);
+        std::lock_guard<std::mutex> guard{st.mutex};
+        st.objects.emplace(handle, std::move(ptr));
+        return handle;
+    }
+
+    /**
+     * Returns empty pointer if handle is not registered
+     */
+    std::shared_ptr<T> peek(int64_t handle) {
+        auto& st = stripe_for(handle);
+        std::lock_guard<std::mutex> guard{st.mutex};
+        auto it = st.objects.find(handle);
+        if (st.objects.end() == it) {
+            return std::shared_ptr<T>();
+        }
+        return it->second;
+    }
+
+    /**
+     * Returns empty pointer if handle is not registered
+     */
+    std::shared_ptr<T> remove(int64_t handle) {
+        auto& st = stripe_for(handle);
+        std::lock_guard<std::mutex> guard{st.mutex};
+        auto it = st.objects.find(handle);
+        if (st.objects.end() == it) {
+            return std::shared_ptr<T>();
+        }
+        auto res = std::move(it->second);
+        st.objects.erase(it);
+        return res;
+    }
+
+    /**
+     * Takes the object, that was removed from the table, from the shared reference,
+     * if the caller holds the last reference to it; then the object is not destroyed
+     * by the table deleter and the caller becomes responsible for it. Returns 'nullptr'
+     * and releases the reference otherwise, object is destroyed with the last one.
+     */
+    static T* release_if_last(std::shared_ptr<T>&& ptr) {
+        // removed objects cannot be peeked, so the count cannot grow
+        if (nullptr == ptr.get() || 1 != ptr.use_count()) {
+            ptr.reset();
+            return nullptr;
+        }
+        auto del = std::get_deleter<std::function<void(T*)>>(ptr);
+        if (nullptr == del) {
+            ptr.reset();
+            return nullptr;
+        }
+        T* res = ptr.get();
+        *del = [](T*) STATICLIB_NOEXCEPT { };
+        ptr.reset();
+        return res;
+    }
+
+private:
+    stripe& stripe_for(int64_t handle) {
+        return stripes[static_cast<size_t>(handle) % stripes.size()];
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_SHARED_HANDLE_REGISTRY_HPP */
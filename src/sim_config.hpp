@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   sim_config.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:32 AM
+ */
+
+#ifndef WILTON_USB_SIM_CONFIG_HPP
+#define WILTON_USB_SIM_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/ranges.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+enum class sim_mode { loopback, echo, source };
+
+/**
+ * Data returned by the simulated device for the matching control request,
+ * negative 'value' or 'index' match any
+ */
+class sim_control_response {
+public:
+    uint8_t request_type = 0;
+    uint8_t request = 0;
+    int32_t value = -1;
+    int32_t index = -1;
+    std::string data;
+
+    sim_control_response(const sim_control_response&) = delete;
+
+    sim_control_response& operator=(const sim_control_response&) = delete;
+
+    sim_control_response(sim_control_response&& other) :
+    request_type(other.request_type),
+    request(other.request),
+    value(other.value),
+    index(other.index),
+    data(std::move(other.data)) { }
+
+    sim_control_response& operator=(sim_control_response&& other) {
+        request_type = other.request_type;
+        request = other.request;
+        value = other.value;
+        index = other.index;
+        data = std::move(other.data);
+        return *this;
+    }
+
+    sim_control_response() { }
+
+    sim_control_response(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("requestType" == name) {
+                this->request_type = static_cast<uint8_t>(fi.as_uint16_positive_or_throw(name));
+            } else if ("request" == name) {
+                this->request = static_cast<uint8_t>(fi.as_uint16_positive_or_throw(name));
+            } else if ("value" == name) {
+                this->value = fi.as_uint16_or_throw(name);
+            } else if ("index" == name) {
+                this->index = fi.as_uint16_or_throw(name);
+            } else if ("dataHex" == name) {
+                this->data = sl::io::string_from_hex(fi.as_string_or_throw(name));
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'simulator.controlResponses' field: [" + name + "]"));
+            }
+        }
+    }
+
+    bool matches(uint8_t rtype, uint8_t req, uint16_t val, uint16_t idx) const {
+        return rtype == request_type && req == request &&
+                (value < 0 || val == value) && (index < 0 || idx == index);
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "requestType", request_type },
+            { "request", request },
+            { "value", value },
+            { "index", index },
+            { "dataHex", sl::io::string_to_hex(data) }
+        };
+    }
+};
+
+/**
+ * In-process device used instead of the hardware when the module
+ * is built with the simulator backend: 'loopback' returns OUT data
+ * as a byte stream, 'echo' returns each OUT transfer as a separate
+ * IN transfer, 'source' discards OUT data and fills every read
+ */
+class sim_config {
+public:
+    sim_mode mode = sim_mode::loopback;
+    uint32_t max_packet_size = 512;
+    // added to every transfer
+    uint32_t latency_micros = 0;
+    // zero means unlimited
+    uint32_t bytes_per_second = 0;
+    // transfers that fail with the simulated error
+    uint32_t errors_per_million = 0;
+    uint32_t seed = 42;
+    std::vector<sim_control_response> control_responses;
+
+    sim_config(const sim_config&) = delete;
+
+    sim_config& operator=(const sim_config&) = delete;
+
+    sim_config(sim_config&& other) :
+    mode(other.mode),
+    max_packet_size(other.max_packet_size),
+    latency_micros(other.latency_micros),
+    bytes_per_second(other.bytes_per_second),
+    errors_per_million(other.errors_per_million),
+    seed(other.seed),
+    control_responses(std::move(other.control_responses)) { }
+
+    sim_config& operator=(sim_config&& other) {
+        mode = other.mode;
+        max_packet_size = other.max_packet_size;
+        latency_micros = other.latency_micros;
+        bytes_per_second = other.bytes_per_second;
+        errors_per_million = other.errors_per_million;
+        seed = other.seed;
+        control_responses = std::move(other.control_responses);
+        return *this;
+    }
+
+    sim_config() { }
+
+    sim_config(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("mode" == name) {
+                this->mode = parse_mode(fi);
+            } else if ("maxPacketSize" == name) {
+                this->max_packet_size = fi.as_uint16_positive_or_throw(name);
+            } else if ("latencyMicros" == name) {
+                this->latency_micros = fi.as_uint32_or_throw(name);
+            } else if ("bytesPerSecond" == name) {
+                this->bytes_per_second = fi.as_uint32_or_throw(name);
+            } else if ("errorsPerMillion" == name) {
+                this->errors_per_million = fi.as_uint32_or_throw(name);
+            } else if ("seed" == name) {
+                this->seed = fi.as_uint32_or_throw(name);
+            } else if ("controlResponses" == name) {
+                for (auto& val : fi.as_array_or_throw(name)) {
+                    this->control_responses.emplace_back(sim_control_response(val));
+                }
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'simulator' field: [" + name + "]"));
+            }
+        }
+        if (errors_per_million > 1000000) throw support::exception(TRACEMSG(
+                "Invalid 'simulator.errorsPerMillion' field: [" + sl::support::to_string(errors_per_million) + "]"));
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "mode", stringify_mode(mode) },
+            { "maxPacketSize", max_packet_size },
+            { "latencyMicros", latency_micros },
+            { "bytesPerSecond", bytes_per_second },
+            { "errorsPerMillion", errors_per_million },
+            { "seed", seed },
+            { "controlResponses", sl::ranges::transform(control_responses, [](const sim_control_response& cr) {
+                return cr.to_json();
+            }).to_vector() }
+        };
+    }
+
+private:
+    static sim_mode parse_mode(const sl::json::field& fi) {
+        auto& str = fi.as_string_nonempty_or_throw(fi.name());
+        if ("loopback" == str) {
+            return sim_mode::loopback;
+        } else if ("echo" == str) {
+            return sim_mode::echo;
+        } else if ("source" == str) {
+            return sim_mode::source;
+        }
+        throw support::exception(TRACEMSG("Invalid 'simulator.mode' field: [" + str + "]," +
+                " supported values: ['loopback', 'echo', 'source']"));
+    }
+
+    static std::string stringify_mode(sim_mode mode) {
+        switch (mode) {
+        case sim_mode::echo: return "echo";
+        case sim_mode::source: return "source";
+        default: return "loopback";
+        }
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_SIM_CONFIG_HPP */
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   spsc_packet_ring.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:04 AM
+ */
+
+#ifndef WILTON_USB_SPSC_PACKET_RING_HPP
+#define WILTON_USB_SPSC_PACKET_RING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "staticlib/config.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Lock-free single-producer/single-consumer queue of packets;
+ * all slots are allocated once on construction with the max packet size,
+ * so pushing and popping packets never allocates
+ */
+class spsc_packet_ring {
+public:
+    struct packet {
+        std::vector<char> data;
+        uint32_t length = 0;
+        int status = 0;
+    };
+
+private:
+    std::vector<packet> slots;
+    // consumer position
+    std::atomic<size_t> head;
+    // producer position
+    std::atomic<size_t> tail;
+
+public:
+    spsc_packet_ring(size_t capacity, size_t packet_size) :
+    slots(capacity),
+    head(0),
+    tail(0) {
+        for (packet& pa : slots) {
+            pa.data.resize(packet_size);
+        }
+    }
+
+    spsc_packet_ring(const spsc_packet_ring&) = delete;
+
+    spsc_packet_ring& operator=(const spsc_packet_ring&) = delete;
+
+    /**
+     * Producer side, returns 'false' if the ring is full and the packet is dropped
+     */
+    bool push(const char* data, uint32_t length, int status) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (t - h >= slots.size()) {
+            return false;
+        }
+        packet& pa = slots[t % slots.size()];
+        uint32_t len = length < pa.data.size() ? length : static_cast<uint32_t>(pa.data.size());
+        if (len > 0) {
+            std::memcpy(pa.data.data(), data, len);
+        }
+        pa.length = len;
+        pa.status = status;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side, returns 'nullptr' if the ring is empty
+     */
+    packet* front() {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        if (h == t) {
+            return nullptr;
+        }
+        return std::addressof(slots[h % slots.size()]);
+    }
+
+    /**
+     * Consumer side, releases the packet returned by 'front'
+     */
+    void pop() {
+        size_t h = head.load(std::memory_order_relaxed);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_SPSC_PACKET_RING_HPP */
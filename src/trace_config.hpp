@@ -0,0 +1,86 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   trace_config.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 8:56 AM
+ */
+
+#ifndef WILTON_USB_TRACE_CONFIG_HPP
+#define WILTON_USB_TRACE_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+class trace_config {
+public:
+    // payload dumps are cut after this number of bytes
+    uint32_t max_bytes = 64;
+    // only every Nth operation is traced
+    uint32_t sample_every = 1;
+
+    trace_config(const trace_config&) = delete;
+
+    trace_config& operator=(const trace_config&) = delete;
+
+    trace_config(trace_config&& other) :
+    max_bytes(other.max_bytes),
+    sample_every(other.sample_every) { }
+
+    trace_config& operator=(trace_config&& other) {
+        max_bytes = other.max_bytes;
+        sample_every = other.sample_every;
+        return *this;
+    }
+
+    trace_config() { }
+
+    trace_config(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("maxBytes" == name) {
+                this->max_bytes = fi.as_uint32_or_throw(name);
+            } else if ("sampleEvery" == name) {
+                this->sample_every = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'trace' field: [" + name + "]"));
+            }
+        }
+    }
+
+    sl::json::value to_json() const {
+        return {
+            { "maxBytes", max_bytes },
+            { "sampleEvery", sample_every }
+        };
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_TRACE_CONFIG_HPP */
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   transact_loop.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:49 AM
+ */
+
+#ifndef WILTON_USB_TRANSACT_LOOP_HPP
+#define WILTON_USB_TRANSACT_LOOP_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/utils.hpp"
+
+#include "transaction_options.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Up to 'window' requests are written before their responses are read,
+ * responses of completed transactions are returned in order; must be
+ * called with both directions locked, so other callers cannot take
+ * a response.
+ *
+ * Writer returns false if the request was not written completely
+ * before the deadline, reader returns an empty string on timeout.
+ *
+ * Responses to the requests, that were written, but not read before
+ * the deadline, are read and discarded for one more timeout interval,
+ * so the next operation does not receive them; if the device does not
+ * send them in this interval, the caller needs to resynchronize
+ * the connection, e.g. by reading until timeout.
+ */
+template<typename Writer, typename Reader>
+std::vector<std::string> transact_loop(const std::vector<sl::io::span<const char>>& requests,
+        const transaction_options& options, uint32_t default_timeout_millis, Writer write_request,
+        Reader read_response) {
+    uint32_t timeout = options.timeout_millis > 0 ? options.timeout_millis : default_timeout_millis;
+    uint64_t finish = sl::utils::current_time_millis_steady() + timeout;
+    auto res = std::vector<std::string>();
+    res.reserve(requests.size());
+    size_t sent = 0;
+    bool write_failed = false;
+    while (!write_failed && res.size() < requests.size()) {
+        while (sent < requests.size() && sent - res.size() < options.window) {
+            if (!write_request(requests[sent], finish)) {
+                write_failed = true;
+                break;
+            }
+            sent += 1;
+        }
+        uint64_t cur = sl::utils::current_time_millis_steady();
+        if (write_failed || cur >= finish) {
+            break;
+        }
+        auto resp = read_response(static_cast<uint32_t>(finish - cur));
+        if (resp.empty()) {
+            break;
+        }
+        res.emplace_back(std::move(resp));
+    }
+    // outstanding responses are discarded
+    size_t outstanding = sent - res.size();
+    uint64_t drain_finish = sl::utils::current_time_millis_steady() + timeout;
+    while (outstanding > 0) {
+        uint64_t cur = sl::utils::current_time_millis_steady();
+        if (cur >= drain_finish || read_response(static_cast<uint32_t>(drain_finish - cur)).empty()) {
+            break;
+        }
+        outstanding -= 1;
+    }
+    return res;
+}
+
+} // namespace
+}
+
+#endif /* WILTON_USB_TRANSACT_LOOP_HPP */
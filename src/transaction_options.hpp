@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   transaction_options.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:20 AM
+ */
+
+#ifndef WILTON_USB_TRANSACTION_OPTIONS_HPP
+#define WILTON_USB_TRANSACTION_OPTIONS_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+
+#include "wilton/support/exception.hpp"
+
+#include "frame_spec.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Describes how the response to each request of the transaction
+ * is read: either fixed 'responseLength' or 'framing'; 'window'
+ * is the number of requests that are written before their responses
+ * are read, for devices with queued commands
+ */
+class transaction_options {
+public:
+    uint32_t response_length = 0;
+    bool framed = false;
+    frame_spec framing;
+    uint32_t window = 1;
+    // zero means connection 'timeoutMillis'
+    uint32_t timeout_millis = 0;
+
+    transaction_options(const transaction_options&) = delete;
+
+    transaction_options& operator=(const transaction_options&) = delete;
+
+    transaction_options(transaction_options&& other) :
+    response_length(other.response_length),
+    framed(other.framed),
+    framing(std::move(other.framing)),
+    window(other.window),
+    timeout_millis(other.timeout_millis) { }
+
+    transaction_options& operator=(transaction_options&& other) {
+        response_length = other.response_length;
+        framed = other.framed;
+        framing = std::move(other.framing);
+        window = other.window;
+        timeout_millis = other.timeout_millis;
+        return *this;
+    }
+
+    transaction_options() { }
+
+    transaction_options(const sl::json::value& json) {
+        for (const sl::json::field& fi : json.as_object()) {
+            auto& name = fi.name();
+            if ("responseLength" == name) {
+                this->response_length = fi.as_uint32_positive_or_throw(name);
+            } else if ("framing" == name) {
+                this->framing = frame_spec(fi.val());
+                this->framed = true;
+            } else if ("window" == name) {
+                this->window = fi.as_uint32_positive_or_throw(name);
+            } else if ("timeoutMillis" == name) {
+                this->timeout_millis = fi.as_uint32_positive_or_throw(name);
+            } else {
+                throw support::exception(TRACEMSG("Unknown 'transaction' field: [" + name + "]"));
+            }
+        }
+        if (0 == response_length && !framed) throw support::exception(TRACEMSG(
+                "Required parameter 'responseLength' or 'framing' not specified"));
+        if (response_length > 0 && framed) throw support::exception(TRACEMSG(
+                "Parameters 'responseLength' and 'framing' cannot be specified together"));
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_TRANSACTION_OPTIONS_HPP */
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   transfer_future.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:00 AM
+ */
+
+#ifndef WILTON_USB_TRANSFER_FUTURE_HPP
+#define WILTON_USB_TRANSFER_FUTURE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/utils.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Result of a transfer that was submitted without waiting for it,
+ * completed from the transfer callback, collected by the caller later;
+ * each future is signalled separately, a thread that waits on transfers
+ * from many devices attaches its own waiter to all of them
+ */
+class transfer_future {
+public:
+    enum class kind { read, write };
+
+private:
+    // signalled by any of the futures it is attached to
+    struct any_waiter {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool signalled = false;
+    };
+
+    kind op;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::string data;
+    uint32_t bytes_written = 0;
+    std::string error;
+    // guarded by 'mutex', waiters detach themselves before returning
+    std::vector<any_waiter*> waiters;
+
+public:
+    explicit transfer_future(kind op) :
+    op(op) { }
+
+    transfer_future(const transfer_future&) = delete;
+
+    transfer_future& operator=(const transfer_future&) = delete;
+
+    kind get_kind() const {
+        return op;
+    }
+
+    void complete_read(std::string&& result) {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            this->data = std::move(result);
+            mark_done();
+        }
+        cv.notify_all();
+    }
+
+    void complete_write(uint32_t written) {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            this->bytes_written = written;
+            mark_done();
+        }
+        cv.notify_all();
+    }
+
+    void fail(const std::string& message) {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            this->error = message;
+            mark_done();
+        }
+        cv.notify_all();
+    }
+
+    bool ready() {
+        std::lock_guard<std::mutex> guard{mutex};
+        return done;
+    }
+
+    /**
+     * Blocks until the transfer is complete, throws on transfer error
+     */
+    std::string take_data() {
+        wait_done();
+        if (!error.empty()) throw support::exception(TRACEMSG(error));
+        return std::move(data);
+    }
+
+    uint32_t take_written() {
+        wait_done();
+        if (!error.empty()) throw support::exception(TRACEMSG(error));
+        return bytes_written;
+    }
+
+    /**
+     * Waits for any of the specified futures to complete,
+     * returns index of the first complete one or '-1' on timeout
+     */
+    static int wait_any(const std::vector<std::shared_ptr<transfer_future>>& futures, uint32_t timeout_millis) {
+        any_waiter waiter;
+        int res = attach_all(futures, waiter);
+        if (-1 != res) {
+            return res;
+        }
+        {
+            std::unique_lock<std::mutex> lock{waiter.mutex};
+            waiter.cv.wait_for(lock, std::chrono::milliseconds(timeout_millis), [&waiter] {
+                return waiter.signalled;
+            });
+        }
+        detach_all(futures, waiter);
+        for (size_t i = 0; i < futures.size(); i++) {
+            if (futures[i]->ready()) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+private:
+    // called under 'mutex', waiter is locked after the future, never before it
+    void mark_done() {
+        this->done = true;
+        for (any_waiter* wa : waiters) {
+            {
+                std::lock_guard<std::mutex> guard{wa->mutex};
+                wa->signalled = true;
+            }
+            wa->cv.notify_one();
+        }
+    }
+
+    void wait_done() {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [this] {
+            return done;
+        });
+    }
+
+    // returns index of the already complete future, no waiter is left attached then
+    static int attach_all(const std::vector<std::shared_ptr<transfer_future>>& futures, any_waiter& waiter) {
+        for (size_t i = 0; i < futures.size(); i++) {
+            auto& fu = *futures[i];
+            bool complete = false;
+            {
+                std::lock_guard<std::mutex> guard{fu.mutex};
+                complete = fu.done;
+                if (!complete) {
+                    fu.waiters.push_back(std::addressof(waiter));
+                }
+            }
+            if (complete) {
+                detach_all(futures, waiter);
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    static void detach_all(const std::vector<std::shared_ptr<transfer_future>>& futures, any_waiter& waiter) {
+        for (auto& fu : futures) {
+            std::lock_guard<std::mutex> guard{fu->mutex};
+            auto& ws = fu->waiters;
+            ws.erase(std::remove(ws.begin(), ws.end(), std::addressof(waiter)), ws.end());
+        }
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_TRANSFER_FUTURE_HPP */
@@ -0,0 +1,319 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   transfer_stats.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:38 AM
+ */
+
+#ifndef WILTON_USB_TRANSFER_STATS_HPP
+#define WILTON_USB_TRANSFER_STATS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/json.hpp"
+#include "staticlib/support.hpp"
+#include "staticlib/utils.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Log-linear latency histogram in nanoseconds: every power-of-two range
+ * is split into 8 linear sub-buckets, so recorded values are kept with
+ * 12.5% precision over the whole 64-bit range; recording is a single
+ * relaxed increment
+ */
+class latency_histogram {
+    static const uint32_t sub_bits = 3;
+    static const uint32_t sub_count = 1 << sub_bits;
+    static const uint32_t buckets_count = sub_count + (64 - sub_bits) * sub_count;
+
+    std::array<std::atomic<uint64_t>, buckets_count> buckets;
+    std::atomic<uint64_t> max_nanos;
+
+public:
+    latency_histogram() :
+    max_nanos(0) {
+        for (auto& bu : buckets) {
+            bu.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    latency_histogram(const latency_histogram&) = delete;
+
+    latency_histogram& operator=(const latency_histogram&) = delete;
+
+    void record(uint64_t nanos) {
+        buckets[index_of(nanos)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t prev = max_nanos.load(std::memory_order_relaxed);
+        while (nanos > prev && !max_nanos.compare_exchange_weak(prev, nanos, std::memory_order_relaxed)) { }
+    }
+
+    /**
+     * Percentiles are reported as the upper bounds of the buckets they fall into
+     */
+    sl::json::value to_json(bool reset) {
+        auto counts = std::vector<uint64_t>(buckets_count);
+        uint64_t total = 0;
+        for (size_t i = 0; i < buckets_count; i++) {
+            counts[i] = reset ? buckets[i].exchange(0, std::memory_order_relaxed) :
+                    buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        uint64_t max = reset ? max_nanos.exchange(0, std::memory_order_relaxed) :
+                max_nanos.load(std::memory_order_relaxed);
+        auto nonempty = std::vector<sl::json::value>();
+        for (size_t i = 0; i < buckets_count; i++) {
+            if (counts[i] > 0) {
+                nonempty.emplace_back(sl::json::value({
+                    { "upToNanos", upper_bound(i) },
+                    { "count", counts[i] }
+                }));
+            }
+        }
+        return {
+            { "count", total },
+            { "p50Nanos", percentile(counts, total, max, 0.5) },
+            { "p90Nanos", percentile(counts, total, max, 0.9) },
+            { "p99Nanos", percentile(counts, total, max, 0.99) },
+            { "p999Nanos", percentile(counts, total, max, 0.999) },
+            { "maxNanos", max },
+            { "buckets", std::move(nonempty) }
+        };
+    }
+
+private:
+    static uint32_t index_of(uint64_t val) {
+        if (val < sub_count) {
+            return static_cast<uint32_t>(val);
+        }
+        uint32_t msb = 0;
+        uint64_t rest = val;
+        for (uint32_t shift = 32; shift > 0; shift >>= 1) {
+            if (rest >= (static_cast<uint64_t>(1) << shift)) {
+                rest >>= shift;
+                msb += shift;
+            }
+        }
+        uint32_t sub = static_cast<uint32_t>(val >> (msb - sub_bits)) & (sub_count - 1);
+        return sub_count + (msb - sub_bits) * sub_count + sub;
+    }
+
+    static uint64_t upper_bound(size_t idx) {
+        if (idx < sub_count) {
+            return static_cast<uint64_t>(idx);
+        }
+        uint32_t range = static_cast<uint32_t>(idx - sub_count) / sub_count;
+        uint64_t sub = static_cast<uint64_t>(idx - sub_count) % sub_count;
+        uint64_t low = (sub_count + sub) << range;
+        return low + ((static_cast<uint64_t>(1) << range) - 1);
+    }
+
+    static uint64_t percentile(const std::vector<uint64_t>& counts, uint64_t total, uint64_t max, double pct) {
+        if (0 == total) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(pct * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint64_t bound = upper_bound(i);
+                return bound < max ? bound : max;
+            }
+        }
+        return max;
+    }
+};
+
+/**
+ * Counters of a single operation type: 'timeouts' are operations, that
+ * transferred nothing before the deadline, 'partial' - ones that transferred
+ * only a part of the requested length; 'errorCodes' are the backend codes
+ * of the failed transfers, including the ones retried after reconnect
+ */
+class operation_stats {
+    // libusb codes are small negative numbers, other codes are only counted as 'other'
+    static const uint32_t codes_count = 16;
+
+    std::atomic<uint64_t> operations;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> partial;
+    std::atomic<uint64_t> failed;
+    std::atomic<uint64_t> timeouts;
+    std::atomic<int64_t> last_error_code;
+    std::array<std::atomic<uint64_t>, codes_count + 1> codes;
+    latency_histogram latency;
+
+public:
+    operation_stats() :
+    operations(0),
+    bytes(0),
+    partial(0),
+    failed(0),
+    timeouts(0),
+    last_error_code(0) {
+        for (auto& co : codes) {
+            co.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    operation_stats(const operation_stats&) = delete;
+
+    operation_stats& operator=(const operation_stats&) = delete;
+
+    void record(uint64_t nanos, size_t requested, size_t transferred) {
+        operations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(transferred, std::memory_order_relaxed);
+        if (0 == transferred && requested > 0) {
+            timeouts.fetch_add(1, std::memory_order_relaxed);
+        } else if (transferred < requested) {
+            partial.fetch_add(1, std::memory_order_relaxed);
+        }
+        latency.record(nanos);
+    }
+
+    void record_failed() {
+        failed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_error_code(int64_t code) {
+        uint64_t idx = code < 0 && -code < static_cast<int64_t>(codes_count) ? static_cast<uint64_t>(-code) : codes_count;
+        codes[idx].fetch_add(1, std::memory_order_relaxed);
+        last_error_code.store(code, std::memory_order_relaxed);
+    }
+
+    sl::json::value to_json(bool reset) {
+        auto errs = std::vector<sl::json::field>();
+        for (uint32_t i = 0; i <= codes_count; i++) {
+            uint64_t count = take(codes[i], reset);
+            if (count > 0) {
+                auto name = codes_count != i ? sl::support::to_string(-static_cast<int64_t>(i)) : std::string("other");
+                errs.emplace_back(std::move(name), count);
+            }
+        }
+        return {
+            { "operations", take(operations, reset) },
+            { "bytes", take(bytes, reset) },
+            { "partial", take(partial, reset) },
+            { "failed", take(failed, reset) },
+            { "timeouts", take(timeouts, reset) },
+            { "lastErrorCode", reset ? last_error_code.exchange(0) : last_error_code.load() },
+            { "errorCodes", std::move(errs) },
+            { "latency", latency.to_json(reset) }
+        };
+    }
+
+private:
+    static uint64_t take(std::atomic<uint64_t>& counter, bool reset) {
+        return reset ? counter.exchange(0, std::memory_order_relaxed) : counter.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Per-connection counters, updated without locks from the operation threads;
+ * reset returns the values accumulated so far, so no counts are lost between
+ * the periodic snapshots; every read, frame read, write and control call
+ * is one operation, transaction counts one write per request and one read
+ * per response; background capture transfers are not counted
+ */
+class transfer_stats {
+    std::atomic<uint64_t> since_millis;
+
+public:
+    // bulk and interrupt reads
+    operation_stats read;
+    // bulk and interrupt writes
+    operation_stats write;
+    operation_stats control;
+
+    transfer_stats() :
+    since_millis(sl::utils::current_time_millis()) { }
+
+    transfer_stats(const transfer_stats&) = delete;
+
+    transfer_stats& operator=(const transfer_stats&) = delete;
+
+    static uint64_t now_nanos() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    sl::json::value to_json(bool reset) {
+        uint64_t now = sl::utils::current_time_millis();
+        uint64_t since = reset ? since_millis.exchange(now) : since_millis.load();
+        return {
+            { "sinceMillis", since },
+            { "bulkRead", read.to_json(reset) },
+            { "bulkWrite", write.to_json(reset) },
+            { "control", control.to_json(reset) }
+        };
+    }
+};
+
+/**
+ * Records the operation on completion, operation that is left
+ * with an exception is counted as failed
+ */
+class stats_scope {
+    operation_stats& stats;
+    uint64_t started;
+    bool recorded = false;
+
+public:
+    explicit stats_scope(operation_stats& stats) :
+    stats(stats),
+    started(transfer_stats::now_nanos()) { }
+
+    stats_scope(const stats_scope&) = delete;
+
+    stats_scope& operator=(const stats_scope&) = delete;
+
+    ~stats_scope() STATICLIB_NOEXCEPT {
+        if (!recorded) {
+            stats.record_failed();
+        }
+    }
+
+    template<typename T>
+    T done(size_t requested, T transferred) {
+        stats.record(transfer_stats::now_nanos() - started, requested, static_cast<size_t>(transferred));
+        recorded = true;
+        return transferred;
+    }
+
+    // frames and transaction responses are not partial, empty one is a timeout
+    std::string done_message(std::string&& message) {
+        size_t len = message.length();
+        stats.record(transfer_stats::now_nanos() - started, len > 0 ? len : 1, len);
+        recorded = true;
+        return std::move(message);
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_TRANSFER_STATS_HPP */
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   transfer_type.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:01 AM
+ */
+
+#ifndef WILTON_USB_TRANSFER_TYPE_HPP
+#define WILTON_USB_TRANSFER_TYPE_HPP
+
+#include <string>
+
+#include "staticlib/config.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/support/exception.hpp"
+
+namespace wilton {
+namespace usb {
+
+enum class transfer_type {
+    bulk,
+    interrupt,
+    isochronous
+};
+
+inline transfer_type parse_transfer_type(const sl::json::field& fi) {
+    auto& str = fi.as_string_nonempty_or_throw(fi.name());
+    if ("bulk" == str) {
+        return transfer_type::bulk;
+    } else if ("interrupt" == str) {
+        return transfer_type::interrupt;
+    } else if ("isochronous" == str) {
+        return transfer_type::isochronous;
+    }
+    throw support::exception(TRACEMSG("Invalid '" + fi.name() + "' field: [" + str + "]," +
+            " supported values: ['bulk', 'interrupt', 'isochronous']"));
+}
+
+inline std::string stringify_transfer_type(transfer_type tt) {
+    switch (tt) {
+    case transfer_type::interrupt: return "interrupt";
+    case transfer_type::isochronous: return "isochronous";
+    default: return "bulk";
+    }
+}
+
+} // namespace
+}
+
+#endif /* WILTON_USB_TRANSFER_TYPE_HPP */
@@ -25,14 +25,26 @@
 #define WILTON_USB_USB_CONFIG_HPP
 
 #include <cstdint>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "staticlib/config.hpp"
 #include "staticlib/support.hpp"
 #include "staticlib/json.hpp"
+#include "staticlib/ranges.hpp"
 
 #include "wilton/support/exception.hpp"
 
+#include "endpoint_set_config.hpp"
+#include "interface_config.hpp"
+#include "iso_config.hpp"
+#include "read_ahead_config.hpp"
+#include "read_completion_config.hpp"
+#include "sim_config.hpp"
+#include "trace_config.hpp"
+#include "transfer_type.hpp"
+
 namespace wilton {
 namespace usb {
 
@@ -40,10 +52,32 @@ class usb_config {
 public:
     uint16_t vendor_id = 0;
     uint16_t product_id = 0;
+    // optional selectors for devices with the same VID/PID
+    std::string serial_number;
+    int32_t bus_number = -1;
+    std::string port_path;
+    // empty means interface 0
+    std::vector<interface_config> interfaces;
+    int32_t alt_setting = -1;
     uint32_t out_endpoint = 0;
     uint32_t in_endpoint = 0;
+    std::map<std::string, endpoint_set_config> endpoint_sets;
     uint32_t timeout_millis = 500;
     uint32_t buffer_size = 4096;
+    // free transfer buffers kept per size class
+    uint32_t pool_size = 4;
+    transfer_type in_transfer_type = transfer_type::bulk;
+    transfer_type out_transfer_type = transfer_type::bulk;
+    read_ahead_config read_ahead;
+    read_completion_config read_completion;
+    iso_config isochronous;
+    trace_config trace;
+    bool auto_reconnect = false;
+    bool pooled = false;
+    uint32_t pool_idle_timeout_millis = 60000;
+    // used only by the simulator backend
+    bool simulated = false;
+    sim_config simulator;
 
     usb_config(const usb_config&) = delete;
 
@@ -52,18 +86,54 @@ public:
     usb_config(usb_config&& other) :
     vendor_id(other.vendor_id),
     product_id(other.product_id),
+    serial_number(std::move(other.serial_number)),
+    bus_number(other.bus_number),
+    port_path(std::move(other.port_path)),
+    interfaces(std::move(other.interfaces)),
+    alt_setting(other.alt_setting),
     out_endpoint(other.out_endpoint),
     in_endpoint(other.in_endpoint),
+    endpoint_sets(std::move(other.endpoint_sets)),
     timeout_millis(other.timeout_millis),
-    buffer_size(other.buffer_size) { }
+    buffer_size(other.buffer_size),
+    pool_size(other.pool_size),
+    in_transfer_type(other.in_transfer_type),
+    out_transfer_type(other.out_transfer_type),
+    read_ahead(std::move(other.read_ahead)),
+    read_completion(std::move(other.read_completion)),
+    isochronous(std::move(other.isochronous)),
+    trace(std::move(other.trace)),
+    auto_reconnect(other.auto_reconnect),
+    pooled(other.pooled),
+    pool_idle_timeout_millis(other.pool_idle_timeout_millis),
+    simulated(other.simulated),
+    simulator(std::move(other.simulator)) { }
 
     usb_config& operator=(usb_config&& other) {
         vendor_id = other.vendor_id;
         product_id = other.product_id;
+        serial_number = std::move(other.serial_number);
+        bus_number = other.bus_number;
+        port_path = std::move(other.port_path);
+        interfaces = std::move(other.interfaces);
+        alt_setting = other.alt_setting;
         out_endpoint = other.out_endpoint;
         in_endpoint = other.in_endpoint;
+        endpoint_sets = std::move(other.endpoint_sets);
         timeout_millis = other.timeout_millis;
         buffer_size = other.buffer_size;
+        pool_size = other.pool_size;
+        in_transfer_type = other.in_transfer_type;
+        out_transfer_type = other.out_transfer_type;
+        read_ahead = std::move(other.read_ahead);
+        read_completion = std::move(other.read_completion);
+        isochronous = std::move(other.isochronous);
+        trace = std::move(other.trace);
+        auto_reconnect = other.auto_reconnect;
+        pooled = other.pooled;
+        pool_idle_timeout_millis = other.pool_idle_timeout_millis;
+        simulated = other.simulated;
+        simulator = std::move(other.simulator);
         return *this;
     }
 
@@ -76,12 +146,53 @@ public:
                 this->vendor_id = fi.as_uint16_positive_or_throw(name);
             } else if ("productId" == name) {
                 this->product_id = fi.as_uint16_positive_or_throw(name);
+            } else if ("serialNumber" == name) {
+                this->serial_number = fi.as_string_nonempty_or_throw(name);
+            } else if ("busNumber" == name) {
+                this->bus_number = fi.as_uint16_or_throw(name);
+            } else if ("portPath" == name) {
+                this->port_path = fi.as_string_nonempty_or_throw(name);
+            } else if ("interfaces" == name) {
+                for (auto& val : fi.as_array_or_throw(name)) {
+                    this->interfaces.emplace_back(interface_config(val));
+                }
+            } else if ("altSetting" == name) {
+                this->alt_setting = fi.as_uint16_or_throw(name);
+            } else if ("endpointSets" == name) {
+                for (const sl::json::field& en : fi.as_object_or_throw(name)) {
+                    this->endpoint_sets.emplace(en.name(), endpoint_set_config(en.val()));
+                }
             } else if ("outEndpoint" == name) {
                 this->out_endpoint = fi.as_uint32_positive_or_throw(name);
             } else if ("inEndpoint" == name) {
                 this->in_endpoint = fi.as_uint32_positive_or_throw(name);
             } else if ("timeoutMillis" == name) {
                 this->timeout_millis = fi.as_uint32_positive_or_throw(name);
+            } else if ("bufferSize" == name) {
+                this->buffer_size = fi.as_uint32_positive_or_throw(name);
+            } else if ("poolSize" == name) {
+                this->pool_size = fi.as_uint32_or_throw(name);
+            } else if ("inTransferType" == name) {
+                this->in_transfer_type = parse_transfer_type(fi);
+            } else if ("outTransferType" == name) {
+                this->out_transfer_type = parse_transfer_type(fi);
+            } else if ("readAhead" == name) {
+                this->read_ahead = read_ahead_config(fi.val());
+            } else if ("readCompletion" == name) {
+                this->read_completion = read_completion_config(fi.val());
+            } else if ("isochronous" == name) {
+                this->isochronous = iso_config(fi.val());
+            } else if ("trace" == name) {
+                this->trace = trace_config(fi.val());
+            } else if ("autoReconnect" == name) {
+                this->auto_reconnect = fi.as_bool_or_throw(name);
+            } else if ("pooled" == name) {
+                this->pooled = fi.as_bool_or_throw(name);
+            } else if ("poolIdleTimeoutMillis" == name) {
+                this->pool_idle_timeout_millis = fi.as_uint32_positive_or_throw(name);
+            } else if ("simulator" == name) {
+                this->simulator = sim_config(fi.val());
+                this->simulated = true;
             } else {
                 throw support::exception(TRACEMSG("Unknown 'usb_config' field: [" + name + "]"));
             }
@@ -94,17 +205,57 @@ public:
                 "Invalid 'usb.outEndpoint' field: []"));
         if (0 == in_endpoint) throw support::exception(TRACEMSG(
                 "Invalid 'usb.inEndpoint' field: []"));
+        // transfer buffers are leased from the pool, that is limited to 1 GiB
+        if (buffer_size > (1u << 30)) throw support::exception(TRACEMSG(
+                "Invalid 'usb.bufferSize' field: [" + sl::support::to_string(buffer_size) + "]"));
+        if (interfaces.empty()) {
+            interfaces.emplace_back(interface_config());
+        }
+        for (auto& iface : interfaces) {
+            if (iface.alt_setting < 0) {
+                iface.alt_setting = alt_setting;
+            }
+        }
     }
 
     sl::json::value to_json() const {
         return {
             { "vendorId", vendor_id },
             { "productId", product_id },
+            { "serialNumber", serial_number },
+            { "busNumber", bus_number },
+            { "portPath", port_path },
+            { "interfaces", sl::ranges::transform(interfaces, [](const interface_config& ic) {
+                return ic.to_json();
+            }).to_vector() },
+            { "altSetting", alt_setting },
             { "outEndpoint", out_endpoint },
             { "inEndpoint", in_endpoint },
-            { "timeoutMillis", timeout_millis }
+            { "endpointSets", endpoint_sets_to_json() },
+            { "timeoutMillis", timeout_millis },
+            { "bufferSize", buffer_size },
+            { "poolSize", pool_size },
+            { "inTransferType", stringify_transfer_type(in_transfer_type) },
+            { "outTransferType", stringify_transfer_type(out_transfer_type) },
+            { "readAhead", read_ahead.to_json() },
+            { "readCompletion", read_completion.to_json() },
+            { "isochronous", isochronous.to_json() },
+            { "trace", trace.to_json() },
+            { "autoReconnect", auto_reconnect },
+            { "pooled", pooled },
+            { "poolIdleTimeoutMillis", pool_idle_timeout_millis },
+            { "simulator", simulated ? simulator.to_json() : sl::json::value() }
         };
     }
+
+private:
+    sl::json::value endpoint_sets_to_json() const {
+        auto res = std::vector<sl::json::field>();
+        for (auto& en : endpoint_sets) {
+            res.emplace_back(en.first, en.second.to_json());
+        }
+        return sl::json::value(std::move(res));
+    }
 };
 
 } // namespace
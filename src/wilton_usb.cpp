@@ -23,8 +23,12 @@
 
 #include "wilton/wilton_usb.h"
 
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "staticlib/config.hpp"
 
@@ -34,25 +38,126 @@
 #include "wilton/support/misc.hpp"
 
 #include "connection.hpp"
+#include "control_request.hpp"
+#include "payload_tracer.hpp"
+#include "script_engine.hpp"
+#include "transfer_future.hpp"
 #include "usb_config.hpp"
 
 namespace { // anonymous
 
 const std::string logger = std::string("wilton.USB");
 
+// tickets of submitted async transfers, ticket is released on collect
+// or when the connection, that submitted the transfer, is closed
+class ticket_registry {
+    struct entry {
+        const wilton_USB* owner;
+        std::shared_ptr<wilton::usb::transfer_future> future;
+
+        entry(const wilton_USB* owner, std::shared_ptr<wilton::usb::transfer_future>&& future) :
+        owner(owner),
+        future(std::move(future)) { }
+    };
+
+    std::mutex mutex;
+    std::unordered_map<int64_t, entry> futures;
+    int64_t counter = 0;
+
+public:
+    int64_t put(const wilton_USB* owner, std::shared_ptr<wilton::usb::transfer_future> future) {
+        std::lock_guard<std::mutex> guard{mutex};
+        counter += 1;
+        futures.emplace(counter, entry(owner, std::move(future)));
+        return counter;
+    }
+
+    std::shared_ptr<wilton::usb::transfer_future> peek(int64_t ticket) {
+        std::lock_guard<std::mutex> guard{mutex};
+        auto it = futures.find(ticket);
+        if (futures.end() == it) throw wilton::support::exception(TRACEMSG(
+                "Invalid ticket specified: [" + sl::support::to_string(ticket) + "]"));
+        return it->second.future;
+    }
+
+    std::shared_ptr<wilton::usb::transfer_future> remove(int64_t ticket) {
+        std::lock_guard<std::mutex> guard{mutex};
+        auto it = futures.find(ticket);
+        if (futures.end() == it) throw wilton::support::exception(TRACEMSG(
+                "Invalid ticket specified: [" + sl::support::to_string(ticket) + "]"));
+        auto res = std::move(it->second.future);
+        futures.erase(it);
+        return res;
+    }
+
+    // returns the number of released tickets
+    size_t remove_owned(const wilton_USB* owner) {
+        std::lock_guard<std::mutex> guard{mutex};
+        size_t count = 0;
+        for (auto it = futures.begin(); it != futures.end();) {
+            if (owner == it->second.owner) {
+                it = futures.erase(it);
+                count += 1;
+            } else {
+                ++it;
+            }
+        }
+        return count;
+    }
+};
+
+ticket_registry& tickets() {
+    static ticket_registry registry;
+    return registry;
+}
+
 } // namespace
 
 struct wilton_USB {
 private:
     wilton::usb::connection usb;
+    wilton::usb::payload_tracer trace;
+
+    // prepared control requests are owned by the handle and released with it
+    std::mutex prepared_mutex;
+    std::unordered_map<int64_t, std::shared_ptr<wilton::usb::control_request>> prepared;
+    int64_t prepared_counter = 0;
 
 public:
-    wilton_USB(wilton::usb::connection&& usb) :
-    usb(std::move(usb)) { }
+    wilton_USB(wilton::usb::connection&& usb, const wilton::usb::trace_config& trace_conf) :
+    usb(std::move(usb)),
+    trace(logger, trace_conf) { }
 
     wilton::usb::connection& impl() {
         return usb;
     }
+
+    wilton::usb::payload_tracer& tracer() {
+        return trace;
+    }
+
+    int64_t put_prepared(wilton::usb::control_request&& req) {
+        auto ptr = std::make_shared<wilton::usb::control_request>(std::move(req));
+        std::lock_guard<std::mutex> guard{prepared_mutex};
+        prepared_counter += 1;
+        prepared.emplace(prepared_counter, std::move(ptr));
+        return prepared_counter;
+    }
+
+    std::shared_ptr<wilton::usb::control_request> peek_prepared(int64_t id) {
+        std::lock_guard<std::mutex> guard{prepared_mutex};
+        auto it = prepared.find(id);
+        if (prepared.end() == it) throw wilton::support::exception(TRACEMSG(
+                "Invalid prepared control id specified: [" + sl::support::to_string(id) + "]"));
+        return it->second;
+    }
+
+    void remove_prepared(int64_t id) {
+        std::lock_guard<std::mutex> guard{prepared_mutex};
+        auto count = prepared.erase(id);
+        if (0 == count) throw wilton::support::exception(TRACEMSG(
+                "Invalid prepared control id specified: [" + sl::support::to_string(id) + "]"));
+    }
 };
 
 char* wilton_USB_open(
@@ -70,8 +175,9 @@ char* wilton_USB_open(
                 " VID: [" + sl::support::to_string(uconf.vendor_id) + "]," +
                 " PID: [" + sl::support::to_string(uconf.product_id) + "]," +
                 " timeout: [" + sl::support::to_string(uconf.timeout_millis) + "] ...");
+        auto trace_conf = std::move(uconf.trace);
         auto usb = wilton::usb::connection(std::move(uconf));
-        wilton_USB* usb_ptr = new wilton_USB(std::move(usb));
+        wilton_USB* usb_ptr = new wilton_USB(std::move(usb), trace_conf);
         wilton::support::log_debug(logger, "Connection opened, handle: [" + wilton::support::strhandle(usb_ptr) + "]");
         *usb_out = usb_ptr;
         return nullptr;
@@ -80,24 +186,179 @@ char* wilton_USB_open(
     }
 }
 
+char* wilton_USB_list(
+        const char* conf,
+        int conf_len,
+        char** list_out,
+        int* list_len_out) /* noexcept */ {
+    if (nullptr == conf) return wilton::support::alloc_copy(TRACEMSG("Null 'conf' parameter specified"));
+    if (!sl::support::is_uint16_positive(conf_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'conf_len' parameter specified: [" + sl::support::to_string(conf_len) + "]"));
+    if (nullptr == list_out) return wilton::support::alloc_copy(TRACEMSG("Null 'list_out' parameter specified"));
+    if (nullptr == list_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'list_len_out' parameter specified"));
+    try {
+        auto conf_json = sl::json::load({conf, conf_len});
+        auto uconf = wilton::usb::usb_config(conf_json);
+        auto vec = wilton::usb::connection::list(uconf);
+        wilton::support::log_debug(logger, std::string("Listed USB devices,") +
+                " VID: [" + sl::support::to_string(uconf.vendor_id) + "]," +
+                " PID: [" + sl::support::to_string(uconf.product_id) + "]," +
+                " found: [" + sl::support::to_string(vec.size()) + "]");
+        auto buf = wilton::support::make_json_buffer(sl::json::value(std::move(vec)));
+        *list_out = buf.data();
+        *list_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
 char* wilton_USB_read(
         wilton_USB* usb,
         int len,
         char** data_out,
         int* data_len_out) /* noexcept */ {
     if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    // one more byte is allocated for the terminating zero
+    if (!sl::support::is_uint32_positive(len) || std::numeric_limits<int>::max() == len) {
+        return wilton::support::alloc_copy(TRACEMSG(
+                "Invalid 'len' parameter specified: [" + sl::support::to_string(len) + "]"));
+    }
+    if (nullptr == data_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_out' parameter specified"));
+    if (nullptr == data_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_len_out' parameter specified"));
+    try {
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Reading from USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " length: [" + sl::support::to_string(len) + "] ...");
+        }
+        // device data is received directly into the returned buffer
+        char* buf = wilton_alloc(len + 1);
+        if (nullptr == buf) throw wilton::support::exception(TRACEMSG(
+                "Error allocating read buffer, length: [" + sl::support::to_string(len) + "]"));
+        auto deferred = sl::support::defer([&buf]() STATICLIB_NOEXCEPT {
+            if (nullptr != buf) {
+                wilton_free(buf);
+            }
+        });
+        uint32_t read = usb->impl().read_into(sl::io::make_span(buf, len));
+        buf[read] = '\0';
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Read operation complete,") +
+                    " bytes read: [" + sl::support::to_string(read) + "]," +
+                    " data: [" + usb->tracer().dump(buf, static_cast<size_t>(read)) + "]");
+        }
+        *data_out = buf;
+        *data_len_out = static_cast<int>(read);
+        buf = nullptr;
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_read_endpoint(
+        wilton_USB* usb,
+        const char* endpoint_name,
+        int endpoint_name_len,
+        int len,
+        char** data_out,
+        int* data_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == endpoint_name) return wilton::support::alloc_copy(TRACEMSG("Null 'endpoint_name' parameter specified"));
+    if (!sl::support::is_uint16_positive(endpoint_name_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'endpoint_name_len' parameter specified: [" + sl::support::to_string(endpoint_name_len) + "]"));
     if (!sl::support::is_uint32_positive(len)) return wilton::support::alloc_copy(TRACEMSG(
             "Invalid 'len' parameter specified: [" + sl::support::to_string(len) + "]"));
     if (nullptr == data_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_out' parameter specified"));
     if (nullptr == data_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_len_out' parameter specified"));
     try {
-        wilton::support::log_debug(logger, std::string("Reading from USB connection,") +
-                " handle: [" + wilton::support::strhandle(usb) + "]," +
-                " length: [" + sl::support::to_string(len) + "] ...");
-        std::string res = usb->impl().read(static_cast<uint32_t>(len));
-        wilton::support::log_debug(logger, std::string("Read operation complete,") +
-                " bytes read: [" + sl::support::to_string(res.length()) + "]," +
-                " data: [" + sl::io::format_plain_as_hex(res) + "]");
+        auto name = std::string(endpoint_name, static_cast<uint16_t>(endpoint_name_len));
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Reading from USB endpoint set,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " endpoint set: [" + name + "]," +
+                    " length: [" + sl::support::to_string(len) + "] ...");
+        }
+        std::string res = usb->impl().read_endpoint(name, static_cast<uint32_t>(len));
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Read operation complete,") +
+                    " bytes read: [" + sl::support::to_string(res.length()) + "]," +
+                    " data: [" + usb->tracer().dump(res) + "]");
+        }
+        auto buf = wilton::support::make_string_buffer(res);
+        *data_out = buf.data();
+        *data_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_write_endpoint(
+        wilton_USB* usb,
+        const char* endpoint_name,
+        int endpoint_name_len,
+        const char* data,
+        int data_len,
+        int* len_written_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == endpoint_name) return wilton::support::alloc_copy(TRACEMSG("Null 'endpoint_name' parameter specified"));
+    if (!sl::support::is_uint16_positive(endpoint_name_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'endpoint_name_len' parameter specified: [" + sl::support::to_string(endpoint_name_len) + "]"));
+    if (nullptr == data) return wilton::support::alloc_copy(TRACEMSG("Null 'data' parameter specified"));
+    if (!sl::support::is_uint32_positive(data_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'data_len' parameter specified: [" + sl::support::to_string(data_len) + "]"));
+    if (nullptr == len_written_out) return wilton::support::alloc_copy(TRACEMSG("Null 'len_written_out' parameter specified"));
+    try {
+        auto name = std::string(endpoint_name, static_cast<uint16_t>(endpoint_name_len));
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Writing to USB endpoint set,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " endpoint set: [" + name + "]," +
+                    " data: [" + usb->tracer().dump(data, static_cast<size_t>(data_len)) + "] ...");
+        }
+        uint32_t written = usb->impl().write_endpoint(name, {data, data_len});
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Write operation complete,") +
+                    " bytes written: [" + sl::support::to_string(written) + "]");
+        }
+        *len_written_out = static_cast<int>(written);
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_read_frame(
+        wilton_USB* usb,
+        const char* framing,
+        int framing_len,
+        char** data_out,
+        int* data_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == framing) return wilton::support::alloc_copy(TRACEMSG("Null 'framing' parameter specified"));
+    if (!sl::support::is_uint16_positive(framing_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'framing_len' parameter specified: [" + sl::support::to_string(framing_len) + "]"));
+    if (nullptr == data_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_out' parameter specified"));
+    if (nullptr == data_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_len_out' parameter specified"));
+    try {
+        auto fjson = sl::json::load({framing, framing_len});
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Reading frame from USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " framing: [" + fjson.dumps() + "] ...");
+        }
+        std::string res = usb->impl().read_frame(fjson);
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Read frame operation complete,") +
+                    " bytes read: [" + sl::support::to_string(res.length()) + "]," +
+                    " data: [" + usb->tracer().dump(res) + "]");
+        }
         auto buf = wilton::support::make_string_buffer(res);
         *data_out = buf.data();
         *data_len_out = buf.size_int();
@@ -117,19 +378,18 @@ char* wilton_USB_write(
     if (!sl::support::is_uint32_positive(data_len)) return wilton::support::alloc_copy(TRACEMSG(
             "Invalid 'data_len' parameter specified: [" + sl::support::to_string(data_len) + "]"));
     try {
-        auto data_src = sl::io::array_source(data, data_len);
-        auto hex_sink = sl::io::string_sink();
-        {
-            auto sink = sl::io::make_hex_sink(hex_sink);
-            sl::io::copy_all(data_src, sink);
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Writing data to USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " data: [" + usb->tracer().dump(data, static_cast<size_t>(data_len)) +  "],"
+                    " data_len: [" + sl::support::to_string(data_len) +  "] ...");
         }
-        wilton::support::log_debug(logger, std::string("Writing data to USB connection,") +
-                " handle: [" + wilton::support::strhandle(usb) + "]," +
-                " data: [" + sl::io::format_hex(hex_sink.get_string()) +  "],"
-                " data_len: [" + sl::support::to_string(data_len) +  "] ...");
         uint32_t written = usb->impl().write({data, data_len});
-        wilton::support::log_debug(logger, std::string("Write operation complete,") +
-                " bytes written: [" + sl::support::to_string(written) + "]");
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Write operation complete,") +
+                    " bytes written: [" + sl::support::to_string(written) + "]");
+        }
         *len_written_out = static_cast<int>(written);
         return nullptr;
     } catch (const std::exception& e) {
@@ -137,6 +397,118 @@ char* wilton_USB_write(
     }
 }
 
+char* wilton_USB_writev(
+        wilton_USB* usb,
+        const char** segments,
+        const int* segments_lens,
+        int segments_count,
+        int* len_written_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == segments) return wilton::support::alloc_copy(TRACEMSG("Null 'segments' parameter specified"));
+    if (nullptr == segments_lens) return wilton::support::alloc_copy(TRACEMSG("Null 'segments_lens' parameter specified"));
+    if (!sl::support::is_uint32_positive(segments_count)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'segments_count' parameter specified: [" + sl::support::to_string(segments_count) + "]"));
+    if (nullptr == len_written_out) return wilton::support::alloc_copy(TRACEMSG("Null 'len_written_out' parameter specified"));
+    try {
+        auto vec = std::vector<sl::io::span<const char>>();
+        vec.reserve(static_cast<size_t>(segments_count));
+        uint64_t total = 0;
+        for (int i = 0; i < segments_count; i++) {
+            if (nullptr == segments[i]) throw wilton::support::exception(TRACEMSG(
+                    "Null segment specified, index: [" + sl::support::to_string(i) + "]"));
+            if (segments_lens[i] < 0) throw wilton::support::exception(TRACEMSG(
+                    "Invalid segment length specified, index: [" + sl::support::to_string(i) + "]," +
+                    " length: [" + sl::support::to_string(segments_lens[i]) + "]"));
+            vec.emplace_back(segments[i], static_cast<size_t>(segments_lens[i]));
+            total += static_cast<uint64_t>(segments_lens[i]);
+        }
+        if (total > static_cast<uint64_t>(std::numeric_limits<int>::max())) throw wilton::support::exception(TRACEMSG(
+                "Invalid total segments length specified: [" + sl::support::to_string(total) + "]"));
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Writing segments to USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " segments: [" + sl::support::to_string(segments_count) + "]," +
+                    " data_len: [" + sl::support::to_string(total) + "] ...");
+        }
+        uint32_t written = usb->impl().writev(vec);
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Write operation complete,") +
+                    " bytes written: [" + sl::support::to_string(written) + "]");
+        }
+        *len_written_out = static_cast<int>(written);
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_transact(
+        wilton_USB* usb,
+        const char* options,
+        int options_len,
+        const char** requests,
+        const int* requests_lens,
+        int requests_count,
+        char** data_out,
+        int* data_len_out,
+        int* responses_lens_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == options) return wilton::support::alloc_copy(TRACEMSG("Null 'options' parameter specified"));
+    if (!sl::support::is_uint16_positive(options_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'options_len' parameter specified: [" + sl::support::to_string(options_len) + "]"));
+    if (nullptr == requests) return wilton::support::alloc_copy(TRACEMSG("Null 'requests' parameter specified"));
+    if (nullptr == requests_lens) return wilton::support::alloc_copy(TRACEMSG("Null 'requests_lens' parameter specified"));
+    if (!sl::support::is_uint32_positive(requests_count)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'requests_count' parameter specified: [" + sl::support::to_string(requests_count) + "]"));
+    if (nullptr == data_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_out' parameter specified"));
+    if (nullptr == data_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_len_out' parameter specified"));
+    if (nullptr == responses_lens_out) return wilton::support::alloc_copy(TRACEMSG("Null 'responses_lens_out' parameter specified"));
+    try {
+        auto topts_json = sl::json::load({options, options_len});
+        auto topts = wilton::usb::transaction_options(topts_json);
+        auto vec = std::vector<sl::io::span<const char>>();
+        vec.reserve(static_cast<size_t>(requests_count));
+        for (int i = 0; i < requests_count; i++) {
+            if (nullptr == requests[i]) throw wilton::support::exception(TRACEMSG(
+                    "Null request specified, index: [" + sl::support::to_string(i) + "]"));
+            if (requests_lens[i] < 0) throw wilton::support::exception(TRACEMSG(
+                    "Invalid request length specified, index: [" + sl::support::to_string(i) + "]," +
+                    " length: [" + sl::support::to_string(requests_lens[i]) + "]"));
+            vec.emplace_back(requests[i], static_cast<size_t>(requests_lens[i]));
+        }
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Running transactions on USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " requests: [" + sl::support::to_string(requests_count) + "]," +
+                    " options: [" + topts_json.dumps() + "] ...");
+        }
+        auto responses = usb->impl().transact(vec, topts);
+        auto joined = std::string();
+        for (int i = 0; i < requests_count; i++) {
+            auto idx = static_cast<size_t>(i);
+            if (idx < responses.size()) {
+                joined.append(responses[idx]);
+                responses_lens_out[i] = static_cast<int>(responses[idx].length());
+            } else {
+                responses_lens_out[i] = -1;
+            }
+        }
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Transactions complete,") +
+                    " responses: [" + sl::support::to_string(responses.size()) + "]," +
+                    " data: [" + usb->tracer().dump(joined) + "]");
+        }
+        auto buf = wilton::support::make_string_buffer(joined);
+        *data_out = buf.data();
+        *data_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
 char* wilton_USB_control(
         wilton_USB* usb,
         const char* options,
@@ -151,13 +523,18 @@ char* wilton_USB_control(
     if (nullptr == data_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_len_out' parameter specified"));
     try {
         auto copts = sl::json::load({options, options_len});
-        wilton::support::log_debug(logger, std::string("Sending control command to USB connection,") +
-                " handle: [" + wilton::support::strhandle(usb) + "]," +
-                " options: [" + copts.dumps() +  "] ...");
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Sending control command to USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " options: [" + copts.dumps() +  "] ...");
+        }
         std::string res = usb->impl().control(copts);
-        wilton::support::log_debug(logger, std::string("Control operation complete,") +
-                " bytes read: [" + sl::support::to_string(res.length()) + "]," +
-                " data: [" + sl::io::format_plain_as_hex(res) + "]");
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Control operation complete,") +
+                    " bytes read: [" + sl::support::to_string(res.length()) + "]," +
+                    " data: [" + usb->tracer().dump(res) + "]");
+        }
         auto buf = wilton::support::make_string_buffer(res);
         *data_out = buf.data();
         *data_len_out = buf.size_int();
@@ -167,11 +544,244 @@ char* wilton_USB_control(
     }
 }
 
+char* wilton_USB_control_prepare(
+        wilton_USB* usb,
+        const char* options,
+        int options_len,
+        long long* id_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == options) return wilton::support::alloc_copy(TRACEMSG("Null 'options' parameter specified"));
+    if (!sl::support::is_uint16_positive(options_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'options_len' parameter specified: [" + sl::support::to_string(options_len) + "]"));
+    if (nullptr == id_out) return wilton::support::alloc_copy(TRACEMSG("Null 'id_out' parameter specified"));
+    try {
+        auto copts = sl::json::load({options, options_len});
+        auto req = usb->impl().prepare_control(copts);
+        int64_t id = usb->put_prepared(std::move(req));
+        wilton::support::log_debug(logger, std::string("Control request prepared,") +
+                " handle: [" + wilton::support::strhandle(usb) + "]," +
+                " id: [" + sl::support::to_string(id) + "]," +
+                " options: [" + copts.dumps() + "]");
+        *id_out = static_cast<long long>(id);
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_control_exec(
+        wilton_USB* usb,
+        long long id,
+        int value,
+        int index,
+        const char* data,
+        int data_len,
+        char** data_out,
+        int* data_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (value > std::numeric_limits<uint16_t>::max()) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'value' parameter specified: [" + sl::support::to_string(value) + "]"));
+    if (index > std::numeric_limits<uint16_t>::max()) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'index' parameter specified: [" + sl::support::to_string(index) + "]"));
+    if (nullptr != data && !sl::support::is_uint16(data_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'data_len' parameter specified: [" + sl::support::to_string(data_len) + "]"));
+    if (nullptr == data_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_out' parameter specified"));
+    if (nullptr == data_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_len_out' parameter specified"));
+    try {
+        auto req = usb->peek_prepared(static_cast<int64_t>(id));
+        auto overrides = wilton::usb::control_overrides(value, index, data,
+                nullptr != data ? static_cast<size_t>(data_len) : 0);
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Executing prepared control request,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " id: [" + sl::support::to_string(id) + "]," +
+                    " value: [" + sl::support::to_string(value) + "]," +
+                    " index: [" + sl::support::to_string(index) + "] ...");
+        }
+        std::string res = usb->impl().execute_control(*req, overrides);
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Control operation complete,") +
+                    " bytes read: [" + sl::support::to_string(res.length()) + "]," +
+                    " data: [" + usb->tracer().dump(res) + "]");
+        }
+        auto buf = wilton::support::make_string_buffer(res);
+        *data_out = buf.data();
+        *data_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_control_release(
+        wilton_USB* usb,
+        long long id) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    try {
+        usb->remove_prepared(static_cast<int64_t>(id));
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_run_script(
+        wilton_USB* usb,
+        const char* script,
+        int script_len,
+        char** result_out,
+        int* result_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == script) return wilton::support::alloc_copy(TRACEMSG("Null 'script' parameter specified"));
+    if (!sl::support::is_uint32_positive(script_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'script_len' parameter specified: [" + sl::support::to_string(script_len) + "]"));
+    if (nullptr == result_out) return wilton::support::alloc_copy(TRACEMSG("Null 'result_out' parameter specified"));
+    if (nullptr == result_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'result_len_out' parameter specified"));
+    try {
+        auto script_json = sl::json::load({script, script_len});
+        wilton::usb::script_engine engine(script_json);
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Running script on USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "] ...");
+        }
+        auto res = engine.run(usb->impl());
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Script complete,") +
+                    " result: [" + res.dumps() + "]");
+        }
+        auto buf = wilton::support::make_json_buffer(res);
+        *result_out = buf.data();
+        *result_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_write_file(
+        wilton_USB* usb,
+        const char* options,
+        int options_len,
+        char** result_out,
+        int* result_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == options) return wilton::support::alloc_copy(TRACEMSG("Null 'options' parameter specified"));
+    if (!sl::support::is_uint16_positive(options_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'options_len' parameter specified: [" + sl::support::to_string(options_len) + "]"));
+    if (nullptr == result_out) return wilton::support::alloc_copy(TRACEMSG("Null 'result_out' parameter specified"));
+    if (nullptr == result_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'result_len_out' parameter specified"));
+    try {
+        auto fopts = sl::json::load({options, options_len});
+        bool trace = usb->tracer().begin();
+        if (trace) {
+            wilton::support::log_debug(logger, std::string("Writing file to USB connection,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " options: [" + fopts.dumps() + "] ...");
+        }
+        auto res = usb->impl().write_file(fopts);
+        if (trace) {
+            wilton::support::log_debug(logger, "File write complete, result: [" + res.dumps() + "]");
+        }
+        auto buf = wilton::support::make_json_buffer(res);
+        *result_out = buf.data();
+        *result_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_write_file_stats(
+        wilton_USB* usb,
+        char** stats_out,
+        int* stats_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == stats_out) return wilton::support::alloc_copy(TRACEMSG("Null 'stats_out' parameter specified"));
+    if (nullptr == stats_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'stats_len_out' parameter specified"));
+    try {
+        auto res = usb->impl().write_file_stats();
+        auto buf = wilton::support::make_json_buffer(res);
+        *stats_out = buf.data();
+        *stats_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_stats(
+        wilton_USB* usb,
+        int reset,
+        char** stats_out,
+        int* stats_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == stats_out) return wilton::support::alloc_copy(TRACEMSG("Null 'stats_out' parameter specified"));
+    if (nullptr == stats_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'stats_len_out' parameter specified"));
+    try {
+        auto res = usb->impl().stats(0 != reset);
+        auto buf = wilton::support::make_json_buffer(res);
+        *stats_out = buf.data();
+        *stats_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_capture_start(
+        wilton_USB* usb,
+        const char* options,
+        int options_len) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == options) return wilton::support::alloc_copy(TRACEMSG("Null 'options' parameter specified"));
+    if (!sl::support::is_uint16_positive(options_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'options_len' parameter specified: [" + sl::support::to_string(options_len) + "]"));
+    try {
+        auto copts = sl::json::load({options, options_len});
+        wilton::support::log_debug(logger, std::string("Starting USB capture,") +
+                " handle: [" + wilton::support::strhandle(usb) + "]," +
+                " options: [" + copts.dumps() + "] ...");
+        usb->impl().capture_start(copts);
+        wilton::support::log_debug(logger, "Capture started");
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_capture_stop(
+        wilton_USB* usb,
+        char** result_out,
+        int* result_len_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == result_out) return wilton::support::alloc_copy(TRACEMSG("Null 'result_out' parameter specified"));
+    if (nullptr == result_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'result_len_out' parameter specified"));
+    try {
+        wilton::support::log_debug(logger, std::string("Stopping USB capture,") +
+                " handle: [" + wilton::support::strhandle(usb) + "] ...");
+        auto res = usb->impl().capture_stop();
+        wilton::support::log_debug(logger, "Capture stopped, result: [" + res.dumps() + "]");
+        auto buf = wilton::support::make_json_buffer(res);
+        *result_out = buf.data();
+        *result_len_out = buf.size_int();
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
 char* wilton_USB_close(
         wilton_USB* usb) /* noexcept */ {
     if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
     try {
         wilton::support::log_debug(logger, "Closing USB connection, handle: [" + wilton::support::strhandle(usb) + "] ...");
+        size_t released = tickets().remove_owned(usb);
+        if (released > 0) {
+            wilton::support::log_debug(logger, "Not collected async transfers released,"
+                    " count: [" + sl::support::to_string(released) + "]");
+        }
         delete usb;
         wilton::support::log_debug(logger, "Connection closed");
         return nullptr;
@@ -179,3 +789,118 @@ char* wilton_USB_close(
         return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
     }
 }
+
+char* wilton_USB_read_async(
+        wilton_USB* usb,
+        int len,
+        long long* ticket_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (!sl::support::is_uint32_positive(len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'len' parameter specified: [" + sl::support::to_string(len) + "]"));
+    if (nullptr == ticket_out) return wilton::support::alloc_copy(TRACEMSG("Null 'ticket_out' parameter specified"));
+    try {
+        auto future = usb->impl().read_async(static_cast<uint32_t>(len));
+        int64_t ticket = tickets().put(usb, std::move(future));
+        if (usb->tracer().begin()) {
+            wilton::support::log_debug(logger, std::string("Async read submitted,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " length: [" + sl::support::to_string(len) + "]," +
+                    " ticket: [" + sl::support::to_string(ticket) + "]");
+        }
+        *ticket_out = static_cast<long long>(ticket);
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_write_async(
+        wilton_USB* usb,
+        const char* data,
+        int data_len,
+        long long* ticket_out) /* noexcept */ {
+    if (nullptr == usb) return wilton::support::alloc_copy(TRACEMSG("Null 'usb' parameter specified"));
+    if (nullptr == data) return wilton::support::alloc_copy(TRACEMSG("Null 'data' parameter specified"));
+    if (!sl::support::is_uint32_positive(data_len)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'data_len' parameter specified: [" + sl::support::to_string(data_len) + "]"));
+    if (nullptr == ticket_out) return wilton::support::alloc_copy(TRACEMSG("Null 'ticket_out' parameter specified"));
+    try {
+        auto future = usb->impl().write_async({data, data_len});
+        int64_t ticket = tickets().put(usb, std::move(future));
+        if (usb->tracer().begin()) {
+            wilton::support::log_debug(logger, std::string("Async write submitted,") +
+                    " handle: [" + wilton::support::strhandle(usb) + "]," +
+                    " data: [" + usb->tracer().dump(data, static_cast<size_t>(data_len)) +  "],"
+                    " ticket: [" + sl::support::to_string(ticket) + "]");
+        }
+        *ticket_out = static_cast<long long>(ticket);
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_poll(
+        long long ticket,
+        int* ready_out) /* noexcept */ {
+    if (nullptr == ready_out) return wilton::support::alloc_copy(TRACEMSG("Null 'ready_out' parameter specified"));
+    try {
+        auto future = tickets().peek(static_cast<int64_t>(ticket));
+        *ready_out = future->ready() ? 1 : 0;
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_wait(
+        const long long* tickets_list,
+        int tickets_count,
+        int timeout_millis,
+        int* ready_index_out) /* noexcept */ {
+    if (nullptr == tickets_list) return wilton::support::alloc_copy(TRACEMSG("Null 'tickets' parameter specified"));
+    if (!sl::support::is_uint32_positive(tickets_count)) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'tickets_count' parameter specified: [" + sl::support::to_string(tickets_count) + "]"));
+    if (timeout_millis < 0) return wilton::support::alloc_copy(TRACEMSG(
+            "Invalid 'timeout_millis' parameter specified: [" + sl::support::to_string(timeout_millis) + "]"));
+    if (nullptr == ready_index_out) return wilton::support::alloc_copy(TRACEMSG("Null 'ready_index_out' parameter specified"));
+    try {
+        auto futures = std::vector<std::shared_ptr<wilton::usb::transfer_future>>();
+        futures.reserve(static_cast<size_t>(tickets_count));
+        for (int i = 0; i < tickets_count; i++) {
+            futures.emplace_back(tickets().peek(static_cast<int64_t>(tickets_list[i])));
+        }
+        *ready_index_out = wilton::usb::transfer_future::wait_any(futures, static_cast<uint32_t>(timeout_millis));
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
+
+char* wilton_USB_collect(
+        long long ticket,
+        char** data_out,
+        int* data_len_out,
+        int* len_written_out) /* noexcept */ {
+    if (nullptr == data_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_out' parameter specified"));
+    if (nullptr == data_len_out) return wilton::support::alloc_copy(TRACEMSG("Null 'data_len_out' parameter specified"));
+    if (nullptr == len_written_out) return wilton::support::alloc_copy(TRACEMSG("Null 'len_written_out' parameter specified"));
+    try {
+        auto future = tickets().remove(static_cast<int64_t>(ticket));
+        if (wilton::usb::transfer_future::kind::read == future->get_kind()) {
+            std::string res = future->take_data();
+            auto buf = wilton::support::make_string_buffer(res);
+            *data_out = buf.data();
+            *data_len_out = buf.size_int();
+            *len_written_out = -1;
+        } else {
+            uint32_t written = future->take_written();
+            *data_out = nullptr;
+            *data_len_out = 0;
+            *len_written_out = static_cast<int>(written);
+        }
+        return nullptr;
+    } catch (const std::exception& e) {
+        return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
+    }
+}
@@ -20,8 +20,12 @@
  *
  * Created on September 16, 2017, 8:13 PM
  */
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "staticlib/config.hpp"
 #include "staticlib/io.hpp"
@@ -34,9 +38,12 @@
 #include "wilton/wilton_usb.h"
 
 #include "wilton/support/buffer.hpp"
+#include "wilton/support/logging.hpp"
 #include "wilton/support/registrar.hpp"
-#include "wilton/support/unique_handle_registry.hpp"
 
+#include "base64.hpp"
+#include "shared_handle_registry.hpp"
+#include "worker_pool.hpp"
 // for local statics init only
 #include "connection.hpp"
 
@@ -45,15 +52,317 @@ namespace usb {
 
 namespace { //anonymous
 
+const std::string logger = std::string("wilton.USB");
+
+// used when the connection is closed with the last reference held by
+// another thread, so the error cannot be returned to the caller
+void close_usb(wilton_USB* usb) STATICLIB_NOEXCEPT {
+    char* err = wilton_USB_close(usb);
+    if (nullptr != err) {
+        support::log_error(logger, TRACEMSG(err));
+        wilton_free(err);
+    }
+}
+
+// devices opened together from one config, operations
+// on all members run concurrently on the group threads
+class usb_group {
+public:
+    struct member {
+        std::shared_ptr<wilton_USB> usb;
+        sl::json::value device;
+    };
+
+    std::vector<member> members;
+    worker_pool pool;
+
+    explicit usb_group(std::vector<member>&& members) :
+    members(std::move(members)),
+    pool(std::min(this->members.size(), static_cast<size_t>(64))) { }
+
+    usb_group(const usb_group&) = delete;
+
+    usb_group& operator=(const usb_group&) = delete;
+
+    /**
+     * Returns JSON array with a result object for every member, result
+     * contains device description and either 'result_name' or 'error' field
+     */
+    sl::json::value run(const std::string& result_name, std::function<sl::json::value(wilton_USB*)> op) {
+        auto results = std::vector<sl::json::value>();
+        results.resize(members.size());
+        auto errors = std::vector<std::string>();
+        errors.resize(members.size());
+        auto tasks = std::vector<std::function<void()>>();
+        for (size_t i = 0; i < members.size(); i++) {
+            tasks.emplace_back([this, i, &op, &results, &errors] {
+                try {
+                    results[i] = op(this->members[i].usb.get());
+                } catch (const std::exception& e) {
+                    errors[i] = e.what();
+                }
+            });
+        }
+        pool.run_all(tasks);
+        auto vec = std::vector<sl::json::value>();
+        for (size_t i = 0; i < members.size(); i++) {
+            auto fields = std::vector<sl::json::field>();
+            for (const sl::json::field& fi : members[i].device.as_object()) {
+                fields.emplace_back(fi.name(), fi.val().clone());
+            }
+            if (errors[i].empty()) {
+                fields.emplace_back(result_name, std::move(results[i]));
+            } else {
+                fields.emplace_back("error", errors[i]);
+            }
+            vec.emplace_back(std::move(fields));
+        }
+        return sl::json::value(std::move(vec));
+    }
+};
+
+// initialized from wilton_module_init
+std::shared_ptr<shared_handle_registry<wilton_USB>> usb_registry() {
+    static auto registry = std::make_shared<shared_handle_registry<wilton_USB>>(close_usb);
+    return registry;
+}
+
 // initialized from wilton_module_init
-std::shared_ptr<support::unique_handle_registry<wilton_USB>> usb_registry() {
-    static auto registry = std::make_shared<support::unique_handle_registry<wilton_USB>>(
-            [](wilton_USB* usb) STATICLIB_NOEXCEPT {
-                wilton_USB_close(usb);
+std::shared_ptr<shared_handle_registry<usb_group>> group_registry() {
+    static auto registry = std::make_shared<shared_handle_registry<usb_group>>(
+            [](usb_group* group) STATICLIB_NOEXCEPT {
+                delete group;
             });
     return registry;
 }
 
+std::shared_ptr<usb_group> peek_group(int64_t handle) {
+    auto reg = group_registry();
+    auto group = reg->peek(handle);
+    if (nullptr == group.get()) throw support::exception(TRACEMSG(
+            "Invalid 'groupHandle' parameter specified"));
+    return group;
+}
+
+// handle stays registered while the operation is running,
+// so other threads can use it concurrently
+std::shared_ptr<wilton_USB> peek_usb(int64_t handle) {
+    auto reg = usb_registry();
+    auto usb = reg->peek(handle);
+    if (nullptr == usb.get()) throw support::exception(TRACEMSG(
+            "Invalid 'usbHandle' parameter specified"));
+    return usb;
+}
+
+enum class encoding { hex, base64, binary };
+
+encoding parse_encoding(const sl::json::field& fi) {
+    auto& str = fi.as_string_nonempty_or_throw(fi.name());
+    if ("hex" == str) {
+        return encoding::hex;
+    } else if ("base64" == str) {
+        return encoding::base64;
+    } else if ("binary" == str) {
+        return encoding::binary;
+    }
+    throw support::exception(TRACEMSG("Invalid '" + fi.name() + "' parameter specified: [" + str + "]," +
+            " supported values: ['hex', 'base64', 'binary']"));
+}
+
+support::buffer make_encoded_buffer(const char* out, int out_len, encoding enc) {
+    switch (enc) {
+    case encoding::base64:
+        return support::make_string_buffer(base64::encode(out, static_cast<size_t>(out_len)));
+    case encoding::binary:
+        return support::make_array_buffer(out, out_len);
+    default: {
+        auto src = sl::io::array_source(out, out_len);
+        return support::make_hex_buffer(src);
+    }
+    }
+}
+
+// group results are returned in JSON, so binary encoding is not supported there
+std::string encode_string(const char* out, int out_len, encoding enc) {
+    if (encoding::base64 == enc) {
+        return base64::encode(out, static_cast<size_t>(out_len));
+    }
+    return sl::io::string_to_hex(std::string(out, static_cast<size_t>(out_len)));
+}
+
+// payload is taken either from 'data' or from 'dataHex', never silently from one of them
+void check_single_payload(const std::string& rdata, const std::string& rdatahex) {
+    if (!rdata.empty() && !rdatahex.empty()) throw support::exception(TRACEMSG(
+            "Parameters 'data' and 'dataHex' cannot be specified together"));
+}
+
+encoding parse_group_encoding(const sl::json::field& fi) {
+    auto res = parse_encoding(fi);
+    if (encoding::binary == res) throw support::exception(TRACEMSG(
+            "Invalid '" + fi.name() + "' parameter specified: ['binary']," +
+            " supported values: ['hex', 'base64']"));
+    return res;
+}
+
+int64_t parse_group_handle_only(sl::io::span<const char> data) {
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("groupHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'groupHandle' not specified"));
+    return handle;
+}
+
+// empty 'endpoint' means the main IN endpoint
+support::buffer read_encoded(int64_t handle, int64_t len, encoding enc,
+        const std::string& endpoint = std::string()) {
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = endpoint.empty() ?
+            wilton_USB_read(usb.get(), static_cast<int>(len),
+                    std::addressof(out), std::addressof(out_len)) :
+            wilton_USB_read_endpoint(usb.get(), endpoint.c_str(), static_cast<int>(endpoint.length()),
+                    static_cast<int>(len), std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return make_encoded_buffer(out, out_len, enc);
+}
+
+support::buffer write_decoded(int64_t handle, sl::io::span<const char> sdata,
+        const std::string& endpoint = std::string()) {
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    int written_out = 0;
+    char* err = endpoint.empty() ?
+            wilton_USB_write(usb.get(), sdata.data(),
+                    static_cast<int> (sdata.size()), std::addressof(written_out)) :
+            wilton_USB_write_endpoint(usb.get(), endpoint.c_str(), static_cast<int>(endpoint.length()),
+                    sdata.data(), static_cast<int> (sdata.size()), std::addressof(written_out));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    return support::make_json_buffer({
+        { "bytesWritten", written_out }
+    });
+}
+
+enum class batch_op_kind { read, write, control };
+
+// operations are parsed before the first one is run,
+// so invalid input never leaves the device half-initialized
+struct batch_op {
+    batch_op_kind kind = batch_op_kind::read;
+    int64_t length = -1;
+    std::string payload;
+    // prepared control request, parsed once from 'payload'
+    long long control_id = -1;
+};
+
+// fields of other operation kinds are rejected, not ignored
+void check_batch_fields(const std::string& op, bool first_found, bool second_found, const std::string& names) {
+    if (first_found || second_found) throw support::exception(TRACEMSG(
+            "Parameters " + names + " are not supported for '" + op + "' operation"));
+}
+
+batch_op parse_batch_op(const sl::json::value& val, encoding enc) {
+    auto res = batch_op();
+    auto op = std::ref(sl::utils::empty_string());
+    auto rdatahex = std::ref(sl::utils::empty_string());
+    auto rdata = std::ref(sl::utils::empty_string());
+    for (const sl::json::field& fi : val.as_object()) {
+        auto& name = fi.name();
+        if ("op" == name) {
+            op = fi.as_string_nonempty_or_throw(name);
+        } else if ("length" == name) {
+            res.length = fi.as_uint32_positive_or_throw(name);
+        } else if ("dataHex" == name) {
+            rdatahex = fi.as_string_nonempty_or_throw(name);
+        } else if ("data" == name) {
+            rdata = fi.as_string_nonempty_or_throw(name);
+        } else if ("options" == name) {
+            // checked here, so the wrong type is not reported as unknown field
+            fi.as_object_or_throw(name);
+            res.payload = fi.val().dumps();
+        } else {
+            throw support::exception(TRACEMSG("Unknown 'operations' entry field: [" + name + "]"));
+        }
+    }
+    bool has_length = -1 != res.length;
+    bool has_data = !rdatahex.get().empty() || !rdata.get().empty();
+    bool has_options = !res.payload.empty();
+    if ("read" == op.get()) {
+        res.kind = batch_op_kind::read;
+        if (!has_length) throw support::exception(TRACEMSG(
+                "Required parameter 'length' not specified for 'read' operation"));
+        check_batch_fields(op.get(), has_data, has_options, "'data', 'dataHex' or 'options'");
+    } else if ("write" == op.get()) {
+        res.kind = batch_op_kind::write;
+        check_batch_fields(op.get(), has_length, has_options, "'length' or 'options'");
+        if (rdatahex.get().empty() && rdata.get().empty()) throw support::exception(TRACEMSG(
+                "Required parameter 'dataHex' not specified for 'write' operation"));
+        check_single_payload(rdata.get(), rdatahex.get());
+        if (!rdata.get().empty() && encoding::base64 != enc) throw support::exception(TRACEMSG(
+                "Parameter 'data' requires 'encoding' to be set to 'base64'"));
+        res.payload = !rdata.get().empty() ? base64::decode(rdata.get()) :
+                sl::io::string_from_hex(rdatahex.get());
+    } else if ("control" == op.get()) {
+        res.kind = batch_op_kind::control;
+        if (!has_options) throw support::exception(TRACEMSG(
+                "Required parameter 'options' not specified for 'control' operation"));
+        check_batch_fields(op.get(), has_length, has_data, "'length', 'data' or 'dataHex'");
+    } else {
+        throw support::exception(TRACEMSG("Invalid 'op' field: [" + op.get() + "]," +
+                " supported values: ['read', 'write', 'control']"));
+    }
+    return res;
+}
+
+sl::json::value run_batch_op(wilton_USB* usb, const batch_op& op, encoding enc) {
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = nullptr;
+    switch (op.kind) {
+    case batch_op_kind::write: {
+        int written_out = 0;
+        err = wilton_USB_write(usb, op.payload.data(), static_cast<int>(op.payload.length()),
+                std::addressof(written_out));
+        if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+        return {
+            { "bytesWritten", written_out }
+        };
+    }
+    case batch_op_kind::control:
+        err = wilton_USB_control_exec(usb, op.control_id, -1, -1, nullptr, 0,
+                std::addressof(out), std::addressof(out_len));
+        break;
+    default:
+        err = wilton_USB_read(usb, static_cast<int>(op.length), std::addressof(out), std::addressof(out_len));
+    }
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return {
+        { "data", encode_string(out, out_len, enc) }
+    };
+}
+
 } // namespace
 
 support::buffer open(sl::io::span<const char> data) {
@@ -83,19 +392,51 @@ support::buffer close(sl::io::span<const char> data) {
             "Required parameter 'usbHandle' not specified"));
     // get handle
     auto reg = usb_registry();
-    wilton_USB* ser = reg->remove(handle);
-    if (nullptr == ser) throw support::exception(TRACEMSG(
+    auto usb = reg->remove(handle);
+    if (nullptr == usb.get()) throw support::exception(TRACEMSG(
             "Invalid 'usbHandle' parameter specified"));
-    // call wilton
-    char* err = wilton_USB_close(ser);
-    if (nullptr != err) {
-        reg->put(ser);
-        support::throw_wilton_error(err, TRACEMSG(err));
+    // connection is closed here, or, if other threads are still
+    // using it, when the last of their operations completes
+    wilton_USB* last = shared_handle_registry<wilton_USB>::release_if_last(std::move(usb));
+    if (nullptr != last) {
+        char* err = wilton_USB_close(last);
+        if (nullptr != err) {
+            support::throw_wilton_error(err, TRACEMSG(err));
+        }
     }
     return support::make_null_buffer();
 }
 
 support::buffer read(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    int64_t len = -1;
+    auto enc = encoding::hex;
+    auto rendpoint = std::ref(sl::utils::empty_string());
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("length" == name) {
+            len = fi.as_int64_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_encoding(fi);
+        } else if ("endpoint" == name) {
+            rendpoint = fi.as_string_nonempty_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (-1 == len) throw support::exception(TRACEMSG(
+            "Required parameter 'length' not specified"));
+    return read_encoded(handle, len, enc, rendpoint.get());
+}
+
+// returns read bytes as is, without JSON or hex wrapping
+support::buffer read_raw(sl::io::span<const char> data) {
     // json parse
     auto json = sl::json::load(data);
     int64_t handle = -1;
@@ -114,17 +455,38 @@ support::buffer read(sl::io::span<const char> data) {
             "Required parameter 'usbHandle' not specified"));
     if (-1 == len) throw support::exception(TRACEMSG(
             "Required parameter 'length' not specified"));
+    return read_encoded(handle, len, encoding::binary);
+}
+
+support::buffer read_frame(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto framing = std::string();
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("framing" == name && sl::json::type::object == fi.json_type()) {
+            framing = fi.val().dumps();
+        } else if ("encoding" == name) {
+            enc = parse_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (framing.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'framing' not specified"));
     // get handle
-    auto reg = usb_registry();
-    wilton_USB* ser = reg->remove(handle);
-    if (nullptr == ser) throw support::exception(TRACEMSG(
-            "Invalid 'usbHandle' parameter specified"));
+    auto usb = peek_usb(handle);
     // call wilton
     char* out = nullptr;
     int out_len = 0;
-    char* err = wilton_USB_read(ser, static_cast<int>(len),
+    char* err = wilton_USB_read_frame(usb.get(), framing.c_str(), static_cast<int>(framing.length()),
             std::addressof(out), std::addressof(out_len));
-    reg->put(ser);
     if (nullptr != err) {
         support::throw_wilton_error(err, TRACEMSG(err));
     }
@@ -134,46 +496,70 @@ support::buffer read(sl::io::span<const char> data) {
     auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
         wilton_free(out);
     });
-    // return hex
-    auto src = sl::io::array_source(out, out_len);
-    return support::make_hex_buffer(src);
+    return make_encoded_buffer(out, out_len, enc);
 }
 
-
 support::buffer write(sl::io::span<const char> data) {
     // json parse
     auto json = sl::json::load(data);
     int64_t handle = -1;
     auto rdatahex = std::ref(sl::utils::empty_string());
+    auto rdata = std::ref(sl::utils::empty_string());
+    auto enc = encoding::hex;
+    auto rendpoint = std::ref(sl::utils::empty_string());
     for (const sl::json::field& fi : json.as_object()) {
         auto& name = fi.name();
         if ("usbHandle" == name) {
             handle = fi.as_int64_or_throw(name);
         } else if ("dataHex" == name) {
             rdatahex = fi.as_string_nonempty_or_throw(name);
+        } else if ("data" == name) {
+            rdata = fi.as_string_nonempty_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_encoding(fi);
+        } else if ("endpoint" == name) {
+            rendpoint = fi.as_string_nonempty_or_throw(name);
         } else {
             throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
         }
     }
     if (-1 == handle) throw support::exception(TRACEMSG(
             "Required parameter 'usbHandle' not specified"));
-    if (rdatahex.get().empty()) throw support::exception(TRACEMSG(
+    if (rdatahex.get().empty() && rdata.get().empty()) throw support::exception(TRACEMSG(
             "Required parameter 'dataHex' not specified"));
-    std::string sdata = sl::io::string_from_hex(rdatahex.get());
-    // get handle
-    auto reg = usb_registry();
-    wilton_USB* ser = reg->remove(handle);
-    if (nullptr == ser) throw support::exception(TRACEMSG(
-            "Invalid 'usbHandle' parameter specified"));
-    // call wilton
-    int written_out = 0;
-    char* err = wilton_USB_write(ser, sdata.c_str(), 
-            static_cast<int> (sdata.length()), std::addressof(written_out));
-    reg->put(ser);
-    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
-    return support::make_json_buffer({
-        { "bytesWritten", written_out }
-    });
+    check_single_payload(rdata.get(), rdatahex.get());
+    if (!rdata.get().empty() && encoding::base64 != enc) throw support::exception(TRACEMSG(
+            "Parameter 'data' requires 'encoding' to be set to 'base64',"
+            " use 'usb_write_raw' call to write binary data"));
+    std::string sdata = !rdata.get().empty() ? base64::decode(rdata.get()) :
+            sl::io::string_from_hex(rdatahex.get());
+    return write_decoded(handle, sl::io::make_span(sdata.data(), sdata.length()), rendpoint.get());
+}
+
+// input is a JSON header object '{"usbHandle": 42}' followed by a single
+// newline character, everything after the newline is written as is
+support::buffer write_raw(sl::io::span<const char> data) {
+    const char* nl = static_cast<const char*>(std::memchr(data.data(), '\n', data.size()));
+    if (nullptr == nl) throw support::exception(TRACEMSG(
+            "Invalid raw write input, JSON header must be terminated with a newline"));
+    auto header_len = static_cast<size_t>(nl - data.data());
+    // json parse
+    auto json = sl::json::load(sl::io::make_span(data.data(), header_len));
+    int64_t handle = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    auto payload = sl::io::make_span(nl + 1, data.size() - header_len - 1);
+    if (0 == payload.size()) throw support::exception(TRACEMSG(
+            "Required raw data not specified"));
+    return write_decoded(handle, payload);
 }
 
 support::buffer control(sl::io::span<const char> data) {
@@ -181,12 +567,15 @@ support::buffer control(sl::io::span<const char> data) {
     auto json = sl::json::load(data);
     int64_t handle = -1;
     auto options = std::string();
+    auto enc = encoding::hex;
     for (const sl::json::field& fi : json.as_object()) {
         auto& name = fi.name();
         if ("usbHandle" == name) {
             handle = fi.as_int64_or_throw(name);
         } else if ("options" == name && sl::json::type::object == fi.json_type()) {
             options = fi.val().dumps();
+        } else if ("encoding" == name) {
+            enc = parse_encoding(fi);
         } else {
             throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
         }
@@ -196,16 +585,123 @@ support::buffer control(sl::io::span<const char> data) {
     if (options.empty()) throw support::exception(TRACEMSG(
             "Required parameter 'options' not specified"));
     // get handle
-    auto reg = usb_registry();
-    wilton_USB* usb = reg->remove(handle);
-    if (nullptr == usb) throw support::exception(TRACEMSG(
-            "Invalid 'usbHandle' parameter specified"));
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = wilton_USB_control(usb.get(), options.c_str(), static_cast<int> (options.length()),
+            std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return make_encoded_buffer(out, out_len, enc);
+}
+
+// transaction fields are passed to wilton as is, requests are passed as binary segments
+support::buffer transact(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    const sl::json::value* requests_json = nullptr;
+    auto options_fields = std::vector<sl::json::field>();
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("requests" == name) {
+            requests_json = std::addressof(fi.val());
+        } else if ("encoding" == name) {
+            enc = parse_group_encoding(fi);
+        } else if ("responseLength" == name || "framing" == name ||
+                "window" == name || "timeoutMillis" == name) {
+            options_fields.emplace_back(name, fi.val().clone());
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (nullptr == requests_json) throw support::exception(TRACEMSG(
+            "Required parameter 'requests' not specified"));
+    auto& requests_arr = requests_json->as_array_or_throw("requests");
+    if (requests_arr.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'requests' not specified"));
+    auto requests = std::vector<std::string>();
+    requests.reserve(requests_arr.size());
+    for (auto& val : requests_arr) {
+        auto& str = val.as_string_nonempty_or_throw("requests");
+        requests.emplace_back(encoding::base64 == enc ? base64::decode(str) : sl::io::string_from_hex(str));
+    }
+    auto ptrs = std::vector<const char*>();
+    auto lens = std::vector<int>();
+    for (auto& req : requests) {
+        ptrs.push_back(req.data());
+        lens.push_back(static_cast<int>(req.length()));
+    }
+    auto options = sl::json::value(std::move(options_fields)).dumps();
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    auto resp_lens = std::vector<int>(requests.size(), -1);
+    char* err = wilton_USB_transact(usb.get(), options.c_str(), static_cast<int>(options.length()),
+            ptrs.data(), lens.data(), static_cast<int>(requests.size()),
+            std::addressof(out), std::addressof(out_len), resp_lens.data());
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    // not completed transactions are returned as nulls
+    auto res = std::vector<sl::json::value>();
+    res.reserve(resp_lens.size());
+    int offset = 0;
+    for (int len : resp_lens) {
+        if (len < 0) {
+            res.emplace_back(nullptr);
+        } else {
+            res.emplace_back(encode_string(out + offset, len, enc));
+            offset += len;
+        }
+    }
+    return support::make_json_buffer(sl::json::value(std::move(res)));
+}
+
+support::buffer run_script(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto script = std::string();
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("script" == name && sl::json::type::object == fi.json_type()) {
+            script = fi.val().dumps();
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (script.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'script' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
     // call wilton
     char* out = nullptr;
     int out_len = 0;
-    char* err = wilton_USB_control(usb, options.c_str(), static_cast<int> (options.length()),
+    char* err = wilton_USB_run_script(usb.get(), script.c_str(), static_cast<int>(script.length()),
             std::addressof(out), std::addressof(out_len));
-    reg->put(usb);
     if (nullptr != err) {
         support::throw_wilton_error(err, TRACEMSG(err));
     }
@@ -215,9 +711,727 @@ support::buffer control(sl::io::span<const char> data) {
     auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
         wilton_free(out);
     });
-    // return hex
-    auto src = sl::io::array_source(out, out_len);
-    return support::make_hex_buffer(src);
+    return support::make_array_buffer(out, out_len);
+}
+
+support::buffer write_file(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto options = std::string();
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("options" == name && sl::json::type::object == fi.json_type()) {
+            options = fi.val().dumps();
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (options.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'options' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = wilton_USB_write_file(usb.get(), options.c_str(), static_cast<int>(options.length()),
+            std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return support::make_array_buffer(out, out_len);
+}
+
+support::buffer write_file_stats(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = wilton_USB_write_file_stats(usb.get(), std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return support::make_array_buffer(out, out_len);
+}
+
+support::buffer stats(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    bool reset = false;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("reset" == name) {
+            reset = fi.as_bool_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = wilton_USB_stats(usb.get(), reset ? 1 : 0, std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return support::make_array_buffer(out, out_len);
+}
+
+support::buffer capture_start(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto options = std::string();
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("options" == name && sl::json::type::object == fi.json_type()) {
+            options = fi.val().dumps();
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (options.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'options' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* err = wilton_USB_capture_start(usb.get(), options.c_str(), static_cast<int>(options.length()));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    return support::make_null_buffer();
+}
+
+support::buffer capture_stop(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = wilton_USB_capture_stop(usb.get(), std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return support::make_array_buffer(out, out_len);
+}
+
+support::buffer control_prepare(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto options = std::string();
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("options" == name && sl::json::type::object == fi.json_type()) {
+            options = fi.val().dumps();
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (options.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'options' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    long long id = -1;
+    char* err = wilton_USB_control_prepare(usb.get(), options.c_str(), static_cast<int> (options.length()),
+            std::addressof(id));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    return support::make_json_buffer({
+        { "controlId", static_cast<int64_t>(id) }
+    });
+}
+
+// only the id and optional overrides are passed, prepared options are not parsed again
+support::buffer control_exec(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    int64_t id = -1;
+    int32_t value = -1;
+    int32_t index = -1;
+    auto rdatahex = std::ref(sl::utils::empty_string());
+    auto rdata = std::ref(sl::utils::empty_string());
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("controlId" == name) {
+            id = fi.as_int64_or_throw(name);
+        } else if ("value" == name) {
+            value = fi.as_uint16_or_throw(name);
+        } else if ("index" == name) {
+            index = fi.as_uint16_or_throw(name);
+        } else if ("dataHex" == name) {
+            rdatahex = fi.as_string_nonempty_or_throw(name);
+        } else if ("data" == name) {
+            rdata = fi.as_string_nonempty_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (-1 == id) throw support::exception(TRACEMSG(
+            "Required parameter 'controlId' not specified"));
+    check_single_payload(rdata.get(), rdatahex.get());
+    if (!rdata.get().empty() && encoding::base64 != enc) throw support::exception(TRACEMSG(
+            "Parameter 'data' requires 'encoding' to be set to 'base64'"));
+    bool data_override = !rdata.get().empty() || !rdatahex.get().empty();
+    std::string sdata = !rdata.get().empty() ? base64::decode(rdata.get()) :
+            !rdatahex.get().empty() ? sl::io::string_from_hex(rdatahex.get()) : std::string();
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = wilton_USB_control_exec(usb.get(), id, value, index,
+            data_override ? sdata.data() : nullptr, static_cast<int>(sdata.length()),
+            std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) {
+        support::throw_wilton_error(err, TRACEMSG(err));
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return make_encoded_buffer(out, out_len, enc);
+}
+
+support::buffer control_release(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    int64_t id = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("controlId" == name) {
+            id = fi.as_int64_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (-1 == id) throw support::exception(TRACEMSG(
+            "Required parameter 'controlId' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    char* err = wilton_USB_control_release(usb.get(), id);
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    return support::make_null_buffer();
+}
+
+// runs a sequence of operations on one handle within a single call,
+// results are returned in the same order, failed entry gets 'error' field
+support::buffer batch(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    bool stop_on_error = true;
+    auto enc = encoding::hex;
+    const sl::json::value* ops_json = nullptr;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("operations" == name) {
+            ops_json = std::addressof(fi.val());
+        } else if ("stopOnError" == name) {
+            stop_on_error = fi.as_bool_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_group_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (nullptr == ops_json) throw support::exception(TRACEMSG(
+            "Required parameter 'operations' not specified"));
+    auto& ops_arr = ops_json->as_array_or_throw("operations");
+    if (ops_arr.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'operations' not specified"));
+    auto ops = std::vector<batch_op>();
+    ops.reserve(ops_arr.size());
+    for (auto& val : ops_arr) {
+        ops.emplace_back(parse_batch_op(val, enc));
+    }
+    // get handle
+    auto usb = peek_usb(handle);
+    // control requests are prepared before the first operation is run
+    auto deferred = sl::support::defer([&usb, &ops]() STATICLIB_NOEXCEPT {
+        for (auto& op : ops) {
+            if (-1 != op.control_id) {
+                char* err = wilton_USB_control_release(usb.get(), op.control_id);
+                if (nullptr != err) {
+                    wilton_free(err);
+                }
+            }
+        }
+    });
+    for (auto& op : ops) {
+        if (batch_op_kind::control == op.kind) {
+            long long id = -1;
+            char* err = wilton_USB_control_prepare(usb.get(), op.payload.c_str(),
+                    static_cast<int>(op.payload.length()), std::addressof(id));
+            if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+            op.control_id = id;
+        }
+    }
+    // call wilton
+    auto res = std::vector<sl::json::value>();
+    res.reserve(ops.size());
+    for (auto& op : ops) {
+        try {
+            res.emplace_back(run_batch_op(usb.get(), op, enc));
+        } catch (const std::exception& e) {
+            res.emplace_back(sl::json::value({
+                { "error", std::string(e.what()) }
+            }));
+            if (stop_on_error) {
+                break;
+            }
+        }
+    }
+    return support::make_json_buffer(sl::json::value(std::move(res)));
+}
+
+support::buffer read_async(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    int64_t len = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("length" == name) {
+            len = fi.as_int64_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (-1 == len) throw support::exception(TRACEMSG(
+            "Required parameter 'length' not specified"));
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    long long ticket = -1;
+    char* err = wilton_USB_read_async(usb.get(), static_cast<int>(len), std::addressof(ticket));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    return support::make_json_buffer({
+        { "ticket", static_cast<int64_t>(ticket) }
+    });
+}
+
+support::buffer write_async(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto rdatahex = std::ref(sl::utils::empty_string());
+    auto rdata = std::ref(sl::utils::empty_string());
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("usbHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("dataHex" == name) {
+            rdatahex = fi.as_string_nonempty_or_throw(name);
+        } else if ("data" == name) {
+            rdata = fi.as_string_nonempty_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'usbHandle' not specified"));
+    if (rdatahex.get().empty() && rdata.get().empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'dataHex' not specified"));
+    check_single_payload(rdata.get(), rdatahex.get());
+    if (!rdata.get().empty() && encoding::base64 != enc) throw support::exception(TRACEMSG(
+            "Parameter 'data' requires 'encoding' to be set to 'base64'"));
+    std::string sdata = !rdata.get().empty() ? base64::decode(rdata.get()) :
+            sl::io::string_from_hex(rdatahex.get());
+    // get handle
+    auto usb = peek_usb(handle);
+    // call wilton
+    long long ticket = -1;
+    char* err = wilton_USB_write_async(usb.get(), sdata.data(), static_cast<int>(sdata.length()),
+            std::addressof(ticket));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    return support::make_json_buffer({
+        { "ticket", static_cast<int64_t>(ticket) }
+    });
+}
+
+support::buffer poll(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t ticket = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("ticket" == name) {
+            ticket = fi.as_int64_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == ticket) throw support::exception(TRACEMSG(
+            "Required parameter 'ticket' not specified"));
+    // call wilton
+    int ready = 0;
+    char* err = wilton_USB_poll(static_cast<long long>(ticket), std::addressof(ready));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    return support::make_json_buffer({
+        { "ready", 0 != ready }
+    });
+}
+
+support::buffer wait(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    auto tickets = std::vector<long long>();
+    int64_t timeout = -1;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("tickets" == name) {
+            for (const sl::json::value& va : fi.as_array_or_throw(name)) {
+                tickets.push_back(static_cast<long long>(va.as_int64_or_throw(name)));
+            }
+        } else if ("timeoutMillis" == name) {
+            timeout = fi.as_uint32_or_throw(name);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (tickets.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'tickets' not specified"));
+    if (-1 == timeout) throw support::exception(TRACEMSG(
+            "Required parameter 'timeoutMillis' not specified"));
+    // call wilton
+    int idx = -1;
+    char* err = wilton_USB_wait(tickets.data(), static_cast<int>(tickets.size()),
+            static_cast<int>(timeout), std::addressof(idx));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    if (-1 == idx) {
+        return support::make_json_buffer({
+            { "ticket", sl::json::value() }
+        });
+    }
+    return support::make_json_buffer({
+        { "ticket", static_cast<int64_t>(tickets.at(static_cast<size_t>(idx))) }
+    });
+}
+
+support::buffer collect(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t ticket = -1;
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("ticket" == name) {
+            ticket = fi.as_int64_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == ticket) throw support::exception(TRACEMSG(
+            "Required parameter 'ticket' not specified"));
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    int written = -1;
+    char* err = wilton_USB_collect(static_cast<long long>(ticket),
+            std::addressof(out), std::addressof(out_len), std::addressof(written));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    if (-1 != written) {
+        return support::make_json_buffer({
+            { "bytesWritten", written }
+        });
+    }
+    if (nullptr == out) { // cannot happen
+        return support::make_null_buffer();
+    }
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    return make_encoded_buffer(out, out_len, enc);
+}
+
+// input is the same config as for 'usb_open', device is opened
+// for every attached device that matches VID/PID and selectors
+support::buffer group_open(sl::io::span<const char> data) {
+    auto conf = sl::json::load(data);
+    // call wilton
+    char* out = nullptr;
+    int out_len = 0;
+    char* err = wilton_USB_list(data.data(), static_cast<int>(data.size()),
+            std::addressof(out), std::addressof(out_len));
+    if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+    auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+        wilton_free(out);
+    });
+    auto list = sl::json::load(sl::io::make_span(out, static_cast<size_t>(out_len)));
+    auto members = std::vector<usb_group::member>();
+    for (const sl::json::value& dev : list.as_array_or_throw("devices")) {
+        usb_group::member me;
+        me.device = dev.clone();
+        members.emplace_back(std::move(me));
+    }
+    if (members.empty()) throw support::exception(TRACEMSG(
+            "No USB devices found matching specified config"));
+    auto group = sl::support::make_unique<usb_group>(std::move(members));
+    // members are opened by their location, so each of them gets its own device
+    auto tasks = std::vector<std::function<void()>>();
+    auto errors = std::vector<std::string>();
+    errors.resize(group->members.size());
+    for (size_t i = 0; i < group->members.size(); i++) {
+        tasks.emplace_back([&conf, &group, &errors, i] {
+            auto& me = group->members[i];
+            auto fields = std::vector<sl::json::field>();
+            for (const sl::json::field& fi : conf.as_object()) {
+                if ("busNumber" != fi.name() && "portPath" != fi.name()) {
+                    fields.emplace_back(fi.name(), fi.val().clone());
+                }
+            }
+            fields.emplace_back("busNumber", me.device.getattr("busNumber").clone());
+            fields.emplace_back("portPath", me.device.getattr("portPath").clone());
+            auto mconf = sl::json::value(std::move(fields)).dumps();
+            wilton_USB* usb = nullptr;
+            char* err_open = wilton_USB_open(std::addressof(usb), mconf.c_str(), static_cast<int>(mconf.length()));
+            if (nullptr != err_open) {
+                errors[i] = err_open;
+                wilton_free(err_open);
+                return;
+            }
+            me.usb = std::shared_ptr<wilton_USB>(usb, close_usb);
+        });
+    }
+    group->pool.run_all(tasks);
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (!errors[i].empty()) throw support::exception(TRACEMSG(
+                "Error opening group device: [" + group->members[i].device.dumps() + "]," +
+                " message: [" + errors[i] + "]"));
+    }
+    auto reg = group_registry();
+    int64_t handle = reg->put(group.release());
+    return support::make_json_buffer({
+        { "groupHandle", handle },
+        { "devices", list.clone() }
+    });
+}
+
+support::buffer group_close(sl::io::span<const char> data) {
+    int64_t handle = parse_group_handle_only(data);
+    auto reg = group_registry();
+    auto group = reg->remove(handle);
+    if (nullptr == group.get()) throw support::exception(TRACEMSG(
+            "Invalid 'groupHandle' parameter specified"));
+    group.reset();
+    return support::make_null_buffer();
+}
+
+support::buffer group_read(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    int64_t len = -1;
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("groupHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("length" == name) {
+            len = fi.as_int64_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_group_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'groupHandle' not specified"));
+    if (-1 == len) throw support::exception(TRACEMSG(
+            "Required parameter 'length' not specified"));
+    // get handle
+    auto group = peek_group(handle);
+    // call wilton
+    auto res = group->run("data", [len, enc](wilton_USB* usb) -> sl::json::value {
+        char* out = nullptr;
+        int out_len = 0;
+        char* err = wilton_USB_read(usb, static_cast<int>(len), std::addressof(out), std::addressof(out_len));
+        if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+        auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+            wilton_free(out);
+        });
+        return encode_string(out, out_len, enc);
+    });
+    return support::make_json_buffer(res);
+}
+
+support::buffer group_write(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto rdatahex = std::ref(sl::utils::empty_string());
+    auto rdata = std::ref(sl::utils::empty_string());
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("groupHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("dataHex" == name) {
+            rdatahex = fi.as_string_nonempty_or_throw(name);
+        } else if ("data" == name) {
+            rdata = fi.as_string_nonempty_or_throw(name);
+        } else if ("encoding" == name) {
+            enc = parse_group_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'groupHandle' not specified"));
+    if (rdatahex.get().empty() && rdata.get().empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'dataHex' not specified"));
+    check_single_payload(rdata.get(), rdatahex.get());
+    if (!rdata.get().empty() && encoding::base64 != enc) throw support::exception(TRACEMSG(
+            "Parameter 'data' requires 'encoding' to be set to 'base64'"));
+    std::string sdata = !rdata.get().empty() ? base64::decode(rdata.get()) :
+            sl::io::string_from_hex(rdatahex.get());
+    // get handle
+    auto group = peek_group(handle);
+    // call wilton, same buffer is shared by all members
+    auto res = group->run("bytesWritten", [&sdata](wilton_USB* usb) -> sl::json::value {
+        int written_out = 0;
+        char* err = wilton_USB_write(usb, sdata.data(), static_cast<int>(sdata.length()),
+                std::addressof(written_out));
+        if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+        return written_out;
+    });
+    return support::make_json_buffer(res);
+}
+
+support::buffer group_control(sl::io::span<const char> data) {
+    // json parse
+    auto json = sl::json::load(data);
+    int64_t handle = -1;
+    auto options = std::string();
+    auto enc = encoding::hex;
+    for (const sl::json::field& fi : json.as_object()) {
+        auto& name = fi.name();
+        if ("groupHandle" == name) {
+            handle = fi.as_int64_or_throw(name);
+        } else if ("options" == name && sl::json::type::object == fi.json_type()) {
+            options = fi.val().dumps();
+        } else if ("encoding" == name) {
+            enc = parse_group_encoding(fi);
+        } else {
+            throw support::exception(TRACEMSG("Unknown data field: [" + name + "]"));
+        }
+    }
+    if (-1 == handle) throw support::exception(TRACEMSG(
+            "Required parameter 'groupHandle' not specified"));
+    if (options.empty()) throw support::exception(TRACEMSG(
+            "Required parameter 'options' not specified"));
+    // get handle
+    auto group = peek_group(handle);
+    // call wilton
+    auto res = group->run("data", [&options, enc](wilton_USB* usb) -> sl::json::value {
+        char* out = nullptr;
+        int out_len = 0;
+        char* err = wilton_USB_control(usb, options.c_str(), static_cast<int> (options.length()),
+                std::addressof(out), std::addressof(out_len));
+        if (nullptr != err) support::throw_wilton_error(err, TRACEMSG(err));
+        auto deferred = sl::support::defer([out]() STATICLIB_NOEXCEPT {
+            wilton_free(out);
+        });
+        return encode_string(out, out_len, enc);
+    });
+    return support::make_json_buffer(res);
 }
 
 } // namespace
@@ -226,12 +1440,37 @@ support::buffer control(sl::io::span<const char> data) {
 extern "C" char* wilton_module_init() {
     try {
         wilton::usb::usb_registry();
+        wilton::usb::group_registry();
         wilton::usb::connection::initialize();
         wilton::support::register_wiltoncall("usb_open", wilton::usb::open);
         wilton::support::register_wiltoncall("usb_close", wilton::usb::close);
         wilton::support::register_wiltoncall("usb_read", wilton::usb::read);
         wilton::support::register_wiltoncall("usb_write", wilton::usb::write);
+        wilton::support::register_wiltoncall("usb_read_raw", wilton::usb::read_raw);
+        wilton::support::register_wiltoncall("usb_read_frame", wilton::usb::read_frame);
+        wilton::support::register_wiltoncall("usb_write_raw", wilton::usb::write_raw);
         wilton::support::register_wiltoncall("usb_control", wilton::usb::control);
+        wilton::support::register_wiltoncall("usb_control_prepare", wilton::usb::control_prepare);
+        wilton::support::register_wiltoncall("usb_control_exec", wilton::usb::control_exec);
+        wilton::support::register_wiltoncall("usb_control_release", wilton::usb::control_release);
+        wilton::support::register_wiltoncall("usb_batch", wilton::usb::batch);
+        wilton::support::register_wiltoncall("usb_transact", wilton::usb::transact);
+        wilton::support::register_wiltoncall("usb_run_script", wilton::usb::run_script);
+        wilton::support::register_wiltoncall("usb_write_file", wilton::usb::write_file);
+        wilton::support::register_wiltoncall("usb_write_file_stats", wilton::usb::write_file_stats);
+        wilton::support::register_wiltoncall("usb_stats", wilton::usb::stats);
+        wilton::support::register_wiltoncall("usb_capture_start", wilton::usb::capture_start);
+        wilton::support::register_wiltoncall("usb_capture_stop", wilton::usb::capture_stop);
+        wilton::support::register_wiltoncall("usb_read_async", wilton::usb::read_async);
+        wilton::support::register_wiltoncall("usb_write_async", wilton::usb::write_async);
+        wilton::support::register_wiltoncall("usb_poll", wilton::usb::poll);
+        wilton::support::register_wiltoncall("usb_wait", wilton::usb::wait);
+        wilton::support::register_wiltoncall("usb_collect", wilton::usb::collect);
+        wilton::support::register_wiltoncall("usb_group_open", wilton::usb::group_open);
+        wilton::support::register_wiltoncall("usb_group_close", wilton::usb::group_close);
+        wilton::support::register_wiltoncall("usb_group_read", wilton::usb::group_read);
+        wilton::support::register_wiltoncall("usb_group_write", wilton::usb::group_write);
+        wilton::support::register_wiltoncall("usb_group_control", wilton::usb::group_control);
         return nullptr;
     } catch (const std::exception& e) {
         return wilton::support::alloc_copy(TRACEMSG(e.what() + "\nException raised"));
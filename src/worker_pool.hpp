@@ -0,0 +1,128 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   worker_pool.hpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:10 AM
+ */
+
+#ifndef WILTON_USB_WORKER_POOL_HPP
+#define WILTON_USB_WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "staticlib/config.hpp"
+
+namespace wilton {
+namespace usb {
+
+/**
+ * Fixed set of threads, that run batches of blocking device
+ * operations; tasks must handle their own exceptions
+ */
+class worker_pool {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> queue;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+public:
+    explicit worker_pool(size_t threads_count) {
+        threads.reserve(threads_count);
+        for (size_t i = 0; i < threads_count; i++) {
+            threads.emplace_back([this] {
+                this->work();
+            });
+        }
+    }
+
+    worker_pool(const worker_pool&) = delete;
+
+    worker_pool& operator=(const worker_pool&) = delete;
+
+    ~worker_pool() STATICLIB_NOEXCEPT {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            stopping = true;
+        }
+        cv.notify_all();
+        for (std::thread& th : threads) {
+            th.join();
+        }
+    }
+
+    /**
+     * Runs all the tasks concurrently and blocks until all of them are finished
+     */
+    void run_all(const std::vector<std::function<void()>>& tasks) {
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        size_t remaining = tasks.size();
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            for (const std::function<void()>& task : tasks) {
+                queue.emplace_back([&task, &done_mutex, &done_cv, &remaining] {
+                    try {
+                        task();
+                    } catch (...) {
+                        // tasks report errors through their own results
+                    }
+                    std::lock_guard<std::mutex> done_guard{done_mutex};
+                    remaining -= 1;
+                    done_cv.notify_all();
+                });
+            }
+        }
+        cv.notify_all();
+        std::unique_lock<std::mutex> lock{done_mutex};
+        done_cv.wait(lock, [&remaining] {
+            return 0 == remaining;
+        });
+    }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                cv.wait(lock, [this] {
+                    return stopping || !queue.empty();
+                });
+                if (queue.empty()) {
+                    return;
+                }
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+} // namespace
+}
+
+#endif /* WILTON_USB_WORKER_POOL_HPP */
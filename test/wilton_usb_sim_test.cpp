@@ -0,0 +1,338 @@
+/*
+ * Copyright 2026, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   wilton_usb_sim_test.cpp
+ * Author: alex
+ *
+ * Created on October 16, 2026, 9:51 AM
+ */
+
+// Runs the wiltoncall operations against the simulated device,
+// built only with 'WILTON_USB_BACKEND=sim'.
+//
+// wilton_usb_sim_test [<wiltoncall config json>]
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "staticlib/config.hpp"
+#include "staticlib/config/assert.hpp"
+#include "staticlib/io.hpp"
+#include "staticlib/json.hpp"
+
+#include "wilton/wilton.h"
+#include "wilton/wiltoncall.h"
+
+#include "wilton/support/exception.hpp"
+
+extern "C" char* wilton_module_init();
+
+namespace { // anonymous
+
+const uint8_t vendor_request_in = 0xC0;
+const uint8_t vendor_request_code = 0x01;
+
+void check_err(char* err) {
+    if (nullptr != err) {
+        auto msg = std::string(err);
+        wilton_free(err);
+        throw wilton::support::exception(TRACEMSG(msg));
+    }
+}
+
+std::string call(const std::string& name, const sl::json::value& input) {
+    auto input_str = input.dumps();
+    char* out = nullptr;
+    int out_len = 0;
+    check_err(wiltoncall(name.c_str(), static_cast<int>(name.length()),
+            input_str.c_str(), static_cast<int>(input_str.length()),
+            std::addressof(out), std::addressof(out_len)));
+    if (nullptr == out) {
+        return std::string();
+    }
+    auto res = std::string(out, static_cast<size_t>(out_len));
+    wilton_free(out);
+    return res;
+}
+
+bool call_fails(const std::string& name, const sl::json::value& input) {
+    try {
+        call(name, input);
+        return false;
+    } catch (const std::exception&) {
+        return true;
+    }
+}
+
+// closes the connection when the test case is finished
+class sim_device {
+public:
+    int64_t handle;
+
+    sim_device(const std::string& mode, sl::json::value read_completion = sl::json::value()) {
+        auto responses = std::vector<sl::json::value>();
+        responses.emplace_back(sl::json::value({
+            { "requestType", vendor_request_in },
+            { "request", vendor_request_code },
+            { "dataHex", "cafe" }
+        }));
+        auto conf = sl::json::value({
+            { "vendorId", 0x1234 },
+            { "productId", 0x5678 },
+            { "outEndpoint", 0x02 },
+            { "inEndpoint", 0x81 },
+            { "timeoutMillis", 200 },
+            { "simulator", {
+                    { "mode", mode },
+                    { "controlResponses", std::move(responses) }
+                }
+            }
+        });
+        if (sl::json::type::object == read_completion.json_type()) {
+            conf.as_object().emplace_back("readCompletion", std::move(read_completion));
+        }
+        auto out = call("usb_open", conf);
+        this->handle = sl::json::load(out).getattr("usbHandle").as_int64_or_throw("usbHandle");
+    }
+
+    sim_device(const sim_device&) = delete;
+
+    sim_device& operator=(const sim_device&) = delete;
+
+    ~sim_device() STATICLIB_NOEXCEPT {
+        try {
+            call("usb_close", {
+                { "usbHandle", handle }
+            });
+        } catch (...) {
+            // ignore
+        }
+    }
+
+    void write_hex(const std::string& hex) {
+        auto out = call("usb_write", {
+            { "usbHandle", handle },
+            { "dataHex", hex }
+        });
+        auto written = sl::json::load(out).getattr("bytesWritten").as_int64_or_throw("bytesWritten");
+        slassert(static_cast<int64_t>(hex.length() / 2) == written);
+    }
+
+    std::string read(uint32_t length) {
+        auto out = call("usb_read", {
+            { "usbHandle", handle },
+            { "length", length }
+        });
+        return sl::io::string_from_hex(out);
+    }
+};
+
+void test_loopback() {
+    sim_device dev("loopback");
+    dev.write_hex("01020304");
+    slassert("\x01\x02\x03\x04" == dev.read(4));
+    // queued data is returned only up to the requested length
+    dev.write_hex("0506");
+    slassert("\x05" == dev.read(1));
+    slassert("\x06" == dev.read(1));
+    // timeout without data
+    slassert(dev.read(4).empty());
+}
+
+void test_read_completion() {
+    // separate transfers are collected until the requested length
+    sim_device dev("echo");
+    dev.write_hex("0102");
+    dev.write_hex("0304");
+    slassert("\x01\x02\x03\x04" == dev.read(4));
+
+    // transfer shorter than requested ends the read
+    sim_device short_dev("echo", {
+        { "shortPacket", true }
+    });
+    short_dev.write_hex("0102");
+    short_dev.write_hex("0304");
+    slassert("\x01\x02" == short_dev.read(4));
+    slassert("\x03\x04" == short_dev.read(4));
+
+    // read is finished as soon as 'minLength' bytes are received
+    sim_device min_dev("loopback", {
+        { "minLength", 2 }
+    });
+    min_dev.write_hex("0a0b");
+    slassert("\x0a\x0b" == min_dev.read(8));
+}
+
+void test_source() {
+    sim_device dev("source");
+    auto data = dev.read(4);
+    slassert(4 == data.length());
+    slassert(static_cast<char>(static_cast<uint8_t>(data[0]) + 1) == data[1]);
+}
+
+void test_read_frame() {
+    sim_device dev("loopback");
+    dev.write_hex(sl::io::string_to_hex("abc\ndef\n"));
+    auto framing = sl::json::value({
+        { "type", "delimiter" },
+        { "delimiter", "\n" }
+    });
+    auto first = call("usb_read_frame", {
+        { "usbHandle", dev.handle },
+        { "framing", framing.clone() }
+    });
+    slassert("abc" == sl::io::string_from_hex(first));
+    auto second = call("usb_read_frame", {
+        { "usbHandle", dev.handle },
+        { "framing", framing.clone() }
+    });
+    slassert("def" == sl::io::string_from_hex(second));
+}
+
+void test_transact() {
+    sim_device dev("loopback");
+    auto requests = std::vector<sl::json::value>();
+    requests.emplace_back("0102");
+    requests.emplace_back("0304");
+    requests.emplace_back("0506");
+    auto out = call("usb_transact", {
+        { "usbHandle", dev.handle },
+        { "requests", std::move(requests) },
+        { "responseLength", 2 },
+        { "window", 2 }
+    });
+    auto res = sl::json::load(out);
+    auto& arr = res.as_array_or_throw("transact");
+    slassert(3 == arr.size());
+    slassert("\x01\x02" == sl::io::string_from_hex(arr[0].as_string_or_throw("transact")));
+    slassert("\x03\x04" == sl::io::string_from_hex(arr[1].as_string_or_throw("transact")));
+    slassert("\x05\x06" == sl::io::string_from_hex(arr[2].as_string_or_throw("transact")));
+}
+
+void test_control() {
+    sim_device dev("loopback");
+    auto out = call("usb_control", {
+        { "usbHandle", dev.handle },
+        { "options", {
+                { "requestType", vendor_request_in },
+                { "request", vendor_request_code }
+            }
+        }
+    });
+    slassert("\xca\xfe" == sl::io::string_from_hex(out));
+    // no scripted response, stalled
+    slassert(call_fails("usb_control", {
+        { "usbHandle", dev.handle },
+        { "options", {
+                { "requestType", vendor_request_in },
+                { "request", vendor_request_code + 1 }
+            }
+        }
+    }));
+}
+
+void test_batch() {
+    sim_device dev("loopback");
+    auto ops = std::vector<sl::json::value>();
+    ops.emplace_back(sl::json::value({
+        { "op", "write" },
+        { "dataHex", "0a0b" }
+    }));
+    ops.emplace_back(sl::json::value({
+        { "op", "read" },
+        { "length", 2 }
+    }));
+    ops.emplace_back(sl::json::value({
+        { "op", "control" },
+        { "options", {
+                { "requestType", vendor_request_in },
+                { "request", vendor_request_code }
+            }
+        }
+    }));
+    auto out = call("usb_batch", {
+        { "usbHandle", dev.handle },
+        { "operations", std::move(ops) }
+    });
+    auto res = sl::json::load(out);
+    auto& arr = res.as_array_or_throw("batch");
+    slassert(3 == arr.size());
+    slassert(2 == arr[0].getattr("bytesWritten").as_int64_or_throw("bytesWritten"));
+    slassert("\x0a\x0b" == sl::io::string_from_hex(arr[1].getattr("data").as_string_or_throw("data")));
+    slassert("\xca\xfe" == sl::io::string_from_hex(arr[2].getattr("data").as_string_or_throw("data")));
+}
+
+void test_stats() {
+    sim_device dev("loopback");
+    dev.write_hex("01020304");
+    slassert(4 == dev.read(4).length());
+    slassert(dev.read(4).empty());
+    call("usb_control", {
+        { "usbHandle", dev.handle },
+        { "options", {
+                { "requestType", vendor_request_in },
+                { "request", vendor_request_code }
+            }
+        }
+    });
+    auto stats = sl::json::load(call("usb_stats", {
+        { "usbHandle", dev.handle },
+        { "reset", true }
+    }));
+    auto& wr = stats.getattr("bulkWrite");
+    slassert(1 == wr.getattr("operations").as_int64_or_throw("operations"));
+    slassert(4 == wr.getattr("bytes").as_int64_or_throw("bytes"));
+    auto& rd = stats.getattr("bulkRead");
+    slassert(2 == rd.getattr("operations").as_int64_or_throw("operations"));
+    slassert(4 == rd.getattr("bytes").as_int64_or_throw("bytes"));
+    slassert(1 == rd.getattr("timeouts").as_int64_or_throw("timeouts"));
+    auto& ctl = stats.getattr("control");
+    slassert(1 == ctl.getattr("operations").as_int64_or_throw("operations"));
+    slassert(2 == ctl.getattr("bytes").as_int64_or_throw("bytes"));
+    // counters are cleared by the reset
+    auto cleared = sl::json::load(call("usb_stats", {
+        { "usbHandle", dev.handle }
+    }));
+    slassert(0 == cleared.getattr("bulkWrite").getattr("operations").as_int64_or_throw("operations"));
+    slassert(0 == cleared.getattr("bulkRead").getattr("operations").as_int64_or_throw("operations"));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        if (argc > 1) {
+            auto conf = std::string(argv[1]);
+            check_err(wiltoncall_init(conf.c_str(), static_cast<int>(conf.length())));
+        }
+        check_err(wilton_module_init());
+        test_loopback();
+        test_read_completion();
+        test_source();
+        test_read_frame();
+        test_transact();
+        test_control();
+        test_batch();
+        test_stats();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}